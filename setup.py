@@ -66,9 +66,14 @@ def run(self):
     AUTHOR = "Niklas Koep"
     CFLAGS = "-Wall -Werror -ansi -std=c89".split()
 
+    LIBRARIES = ["jit"]
+    # clock_gettime() lives in librt on older glibc versions.
+    if sys.platform.startswith("linux"):
+        LIBRARIES.append("rt")
+
     ext_modules = [
         Extension("_jit", sources=glob.glob(os.path.join("src", "*.c")),
-                  extra_compile_args=CFLAGS, libraries=["jit"])
+                  extra_compile_args=CFLAGS, libraries=LIBRARIES)
     ]
 
     kwargs = {
@@ -13,12 +13,108 @@
 # limitations under the License.
 
 from functools import wraps
+import hashlib
 import inspect
 import ctypes
+import ctypes.util
+import weakref
 from _ctypes import CFuncPtr as _CFuncPtr, FUNCFLAG_CDECL as _FUNCFLAG_CDECL
 
 from _jit import *
 
+def _describe_type(type_):
+    """Return a hashable structural description of a jit.Type."""
+    if type_ is None:
+        return None
+    kind = type_.get_kind()
+    if type_.is_tagged():
+        return (kind, type_.get_tagged_kind(),
+                _describe_type(type_.get_tagged_type()))
+    if type_.is_pointer():
+        return (kind, _describe_type(type_.get_ref()))
+    if type_.is_signature():
+        return (kind, type_.get_abi(), _describe_type(type_.get_return()),
+                tuple(_describe_type(type_.get_param(i))
+                      for i in range(type_.num_params())))
+    if type_.is_struct() or type_.is_union():
+        return (kind, type_.get_size(), type_.get_alignment(),
+                tuple((type_.get_name(i), type_.get_offset(i),
+                       _describe_type(type_.get_field(i)))
+                      for i in range(type_.num_fields())))
+    return (kind,)
+
+# Getters of constants whose values don't fit into a jit_nint.
+_CONSTANT_GETTERS = {
+    TYPE_FLOAT32: "get_float32_constant",
+    TYPE_FLOAT64: "get_float64_constant",
+    TYPE_NFLOAT: "get_float64_constant",
+    TYPE_LONG: "get_long_constant",
+    TYPE_ULONG: "get_long_constant"
+}
+
+def _hash_function_ir(function):
+    """Compute a digest of the instruction stream of a function which has not
+    been compiled yet. Values and labels are numbered in order of appearance so
+    that functions built from identical code in different places hash to the
+    same digest. Returns None if the function cannot be hashed reliably, e.g.
+    because it calls other JIT'ed functions.
+    """
+    signature = function.get_signature()
+    values = {}
+    for i in range(signature.num_params()):
+        values[hash(function.value_get_param(i))] = ("param", i)
+    labels = {}
+
+    def describe_value(value):
+        if value is None:
+            return None
+        key = hash(value)
+        try:
+            return values[key]
+        except KeyError:
+            pass
+        type_ = value.get_type()
+        if value.is_constant():
+            getter = _CONSTANT_GETTERS.get(
+                type_.normalize().get_kind(), "get_nint_constant")
+            description = ("const", _describe_type(type_),
+                           getattr(value, getter)())
+        else:
+            description = ("value", len(values), _describe_type(type_),
+                           value.is_addressable(), value.is_volatile())
+        values[key] = description
+        return description
+
+    def describe_label(label):
+        if label is None:
+            return None
+        return labels.setdefault(hash(label), len(labels))
+
+    stream = []
+    block = Block.next_(function)
+    while block is not None:
+        stream.append(("block", describe_label(block.get_label())))
+        for insn in block:
+            if insn.get_function() is not None:
+                return None
+            insn_signature = insn.get_signature()
+            stream.append((
+                insn.get_opcode(),
+                describe_value(insn.get_dest()),
+                describe_value(insn.get_value1()),
+                describe_value(insn.get_value2()),
+                describe_label(insn.get_label()),
+                insn.get_name(),
+                insn.get_native(),
+                _describe_type(insn_signature)))
+        block = Block.next_(function, block)
+    return hashlib.sha1(repr(stream)).hexdigest()
+
+# Compiled functions shared by all builds_function decorators, keyed on the
+# digest of their IR and the description of their signature. Entries disappear
+# once no decorator uses the function anymore.
+_ir_cache = weakref.WeakValueDictionary()
+
 def builds_function(context, signature):
     num_params = signature.num_params()
 
@@ -55,7 +151,18 @@ def get_compiled_function():
                 function = Function(context, signature)
                 args = [function.value_get_param(i) for i in range(num_params)]
                 function.insn_return(f(*args))
-                function.compile_()
+                digest = _hash_function_ir(function)
+                key = (digest, _describe_type(signature))
+                shared = _ir_cache.get(key) if digest is not None else None
+                if shared is not None:
+                    # An identical function has been compiled before, so drop
+                    # the one we just built.
+                    function.abandon()
+                    function = shared
+                else:
+                    function.compile_()
+                    if digest is not None:
+                        _ir_cache[key] = function
                 try:
                     function = Closure(function)
                 except ValueError:
@@ -69,6 +176,174 @@ def wrapper(*args):
         return wrapper
     return decorator
 
+class CodeCache(object):
+    """Bounded code memory for functions which are generated on the fly.
+
+    LibJIT cannot release the code of an individual function, only that of a
+    whole context. Functions are therefore compiled into generations of
+    contexts whose code caches are each limited to `limit' bytes through
+    OPTION_CACHE_LIMIT. Once the current generation is full, a new one is
+    started and only the `generations' most recent ones are kept. Dropping a
+    generation destroys its context together with the code of its functions,
+    which get rebuilt in the current generation the next time they are called.
+    Code memory is thus bounded by roughly `generations' times `limit'.
+    """
+
+    def __init__(self, limit, generations=2):
+        if limit < 1:
+            raise ValueError("limit must be positive")
+        if generations < 1:
+            raise ValueError("generations must be at least 1")
+        self.limit = limit
+        self.generations = generations
+        # Pairs of a context and the functions compiled into it, oldest first.
+        # These are the only strong references to the functions.
+        self._generations = []
+        self.rotate()
+
+    def get_context(self):
+        """Return the context of the current generation."""
+        return self._generations[-1][0]
+
+    def rotate(self):
+        """Start a new generation, dropping the oldest one if more than
+        `generations' remain.
+        """
+        context = Context()
+        context.set_meta_numeric(OPTION_CACHE_LIMIT, self.limit)
+        self._generations.append((context, []))
+        if len(self._generations) > self.generations:
+            del self._generations[0]
+
+    def _compile(self, signature, build):
+        for attempt in range(2):
+            context, functions = self._generations[-1]
+            function = Function(context, signature)
+            build(function)
+            try:
+                function.compile_()
+            except CompileError as e:
+                if attempt or e.result not in (RESULT_OUT_OF_MEMORY,
+                                               RESULT_MEMORY_FULL):
+                    raise
+                function.abandon()
+                self.rotate()
+            else:
+                functions.append(function)
+                return function
+
+    def add(self, signature, build):
+        """Return a CachedFunction with signature `signature' whose body is
+        emitted by calling `build' with a new jit.Function.
+        """
+        return CachedFunction(self, signature, build)
+
+class CachedFunction(object):
+    """A function of a CodeCache which is compiled when it is first called and
+    rebuilt after its generation has been dropped.
+    """
+
+    def __init__(self, cache, signature, build):
+        self.cache = cache
+        self.signature = signature
+        self.build = build
+        self._function = None
+
+    def get_function(self):
+        """Return the compiled jit.Function. Holding on to it keeps its
+        generation's code alive.
+        """
+        function = self._function() if self._function else None
+        if function is None:
+            function = self.cache._compile(self.signature, self.build)
+            self._function = weakref.ref(function)
+        return function
+
+    def __call__(self, *args):
+        return self.get_function()(*args)
+
+class NativeSymbol(object):
+    """A native function which can be called from JIT'ed code.
+
+    The address of `name' in the shared library `library' is resolved once per
+    (library, name) pair. `library' may be a file name such as "libm.so.6", a
+    name understood by ctypes.util.find_library such as "m", or None to search
+    the symbols of the running process.
+    """
+    _libraries = {}
+    _addresses = {}
+
+    def __init__(self, library, name, signature, flags=0):
+        if not signature.is_signature():
+            raise ValueError("signature must be a signature type")
+        self.library = library
+        self.name = name
+        self.signature = signature
+        self.flags = flags
+        self.address = NativeSymbol.resolve(library, name)
+
+    @staticmethod
+    def _load_library(library):
+        try:
+            return NativeSymbol._libraries[library]
+        except KeyError:
+            pass
+        try:
+            handle = ctypes.CDLL(library)
+        except OSError:
+            path = ctypes.util.find_library(library)
+            if path is None:
+                raise
+            handle = ctypes.CDLL(path)
+        NativeSymbol._libraries[library] = handle
+        return handle
+
+    @staticmethod
+    def resolve(library, name):
+        """Return the address of symbol `name' in `library'."""
+        key = (library, name)
+        try:
+            return NativeSymbol._addresses[key]
+        except KeyError:
+            pass
+        handle = NativeSymbol._load_library(library)
+        try:
+            symbol = getattr(handle, name)
+        except AttributeError:
+            raise ValueError(
+                "symbol '%s' not found in '%s'" % (name, library))
+        address = ctypes.cast(symbol, ctypes.c_void_p).value
+        NativeSymbol._addresses[key] = address
+        return address
+
+    def _coerce_arg(self, func, arg, type_):
+        if isinstance(arg, Value):
+            return arg
+        kind = type_.normalize().get_kind()
+        if kind == TYPE_FLOAT32:
+            return Value.create_float32_constant(func, type_, arg)
+        elif kind in (TYPE_FLOAT64, TYPE_NFLOAT):
+            return Value.create_float64_constant(func, type_, arg)
+        elif kind in (TYPE_LONG, TYPE_ULONG):
+            return Value.create_long_constant(func, type_, arg)
+        return Value.create_nint_constant(func, type_, arg)
+
+    def __call__(self, func, *args):
+        """Emit a call to the native function into `func' and return the
+        jit.Value holding the result. Python numbers are converted to constants
+        of the corresponding parameter type.
+        """
+        num_params = self.signature.num_params()
+        args = [self._coerce_arg(func, arg, self.signature.get_param(i))
+                if i < num_params else arg
+                for i, arg in enumerate(args)]
+        return func.insn_call_native(
+            self.name, self.address, self.signature, args, self.flags)
+
+    def __repr__(self):
+        return "<jit.NativeSymbol '%s' from %r at 0x%x>" % (
+            self.name, self.library, self.address)
+
 def _determine_nint_type(**kwargs):
     if not (len(kwargs) == 1 and "signed" in kwargs):
         raise ValueError("need keyword argument 'signed'")
@@ -121,6 +396,13 @@ class Closure(_CFuncPtr):
         Type.SYS_LONG_DOUBLE: ctypes.c_longdouble
     }
 
+    # Conversions of derived types and of whole signatures. Creating ctypes
+    # aggregate classes is expensive, so they are only created once per
+    # jit.Type. The caches are keyed weakly so that entries disappear along
+    # with the types.
+    _ctypes_cache = weakref.WeakKeyDictionary()
+    _signature_cache = weakref.WeakKeyDictionary()
+
     def __new__(cls, function):
         if not isinstance(function, Function):
             raise TypeError("function must be an instance of jit.Function")
@@ -137,9 +419,16 @@ def __init__(self, function):
         super(Closure, self).__init__()
         self._function = function
         signature = function.get_signature()
-        self.restype = self._convert_libjit_to_ctypes(signature.get_return())
-        self.argtypes = [self._convert_libjit_to_ctypes(signature.get_param(i))
-                         for i in range(signature.num_params())]
+        try:
+            restype, argtypes = Closure._signature_cache[signature]
+        except KeyError:
+            convert = self._convert_libjit_to_ctypes
+            restype = convert(signature.get_return())
+            argtypes = tuple(convert(signature.get_param(i))
+                             for i in range(signature.num_params()))
+            Closure._signature_cache[signature] = (restype, argtypes)
+        self.restype = restype
+        self.argtypes = argtypes
 
     @staticmethod
     def _convert_libjit_to_ctypes(type_):
@@ -147,17 +436,24 @@ def _convert_libjit_to_ctypes(type_):
             return Closure._LIBJIT_TO_CTYPES[type_]
         except KeyError:
             pass
+        try:
+            return Closure._ctypes_cache[type_]
+        except KeyError:
+            pass
         if type_.is_pointer():
             ref_type = type_.get_ref()
-            return ctypes.POINTER(Closure._convert_libjit_to_ctypes(ref_type))
+            ctype = ctypes.POINTER(Closure._convert_libjit_to_ctypes(ref_type))
         elif type_.is_struct():
-            return Closure._create_aggregate_type(ctypes.Structure, type_)
+            ctype = Closure._create_aggregate_type(ctypes.Structure, type_)
         elif type_.is_union():
-            return Closure._create_aggregate_type(ctypes.Union, type_)
-        # TODO: Test if the type is tagged with jit.TYPETAG_NAME to obtain a
-        #       proper name for the exception.
-        raise ValueError(
-            "failed to determine ctypes conversion for '%s'" % type_)
+            ctype = Closure._create_aggregate_type(ctypes.Union, type_)
+        else:
+            # TODO: Test if the type is tagged with jit.TYPETAG_NAME to obtain
+            #       a proper name for the exception.
+            raise ValueError(
+                "failed to determine ctypes conversion for '%s'" % type_)
+        Closure._ctypes_cache[type_] = ctype
+        return ctype
 
     @staticmethod
     def _create_aggregate_type(base_class, type_):
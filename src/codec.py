@@ -0,0 +1,186 @@
+# python-libjit, Copyright 2014 Niklas Koep
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Compiled codecs converting between fixed-layout binary records and columns.
+
+The layout of a record is described by a struct type created with
+`jit.Type.create_struct'. Field offsets are taken from the type, so packed or
+otherwise non-native layouts can be described with `jit.Type.set_offset' and
+`jit.Type.set_size_and_alignment'.
+"""
+
+import sys
+
+from _jit import ABI_CDECL, TYPE_VOID, Context, Function, Insn, Type
+from kernels import _advance, _constant, _local_copy, _unrolled_loop
+
+BYTEORDERS = ("native", "little", "big")
+
+# Unsigned integer types used to move fields of a given size around bitwise.
+_UNSIGNED_TYPES = {
+    1: Type.UBYTE,
+    2: Type.USHORT,
+    4: Type.UINT,
+    8: Type.ULONG
+}
+
+def _byteswap(function, value, type_):
+    """Emit code reversing the bytes of the unsigned integer `value'."""
+    size = type_.get_size()
+    mask = _constant(function, type_, 0xff)
+    result = None
+    for k in range(size):
+        byte = Insn.ushr(function, value, _constant(function, type_, 8 * k))
+        byte = (byte & mask) << _constant(function, type_, 8 * (size - 1 - k))
+        result = byte if result is None else result | byte
+    return Insn.convert(function, result, type_, False)
+
+class Codec(object):
+    """Compiled converter between records of `type' and column buffers.
+
+    `decoder' is a jit.Function taking a pointer to the records, one pointer
+    per field to the column receiving the field values, and the number of
+    records. `encoder' takes the column pointers first, followed by a pointer
+    to the records and the number of records.
+    """
+
+    def __init__(self, type_, byteorder, decoder, encoder):
+        self.type = type_
+        self.byteorder = byteorder
+        self.names = tuple(type_.get_name(i)
+                           for i in range(type_.num_fields()))
+        self.fields = tuple(type_.get_field(i)
+                            for i in range(type_.num_fields()))
+        self.decoder = decoder
+        self.encoder = encoder
+
+    def _count(self, records, columns):
+        if len(columns) != len(self.fields):
+            raise ValueError("expected %d columns, got %d" %
+                             (len(self.fields), len(columns)))
+        count, remainder = divmod(len(buffer(records)), self.type.get_size())
+        if remainder:
+            raise ValueError(
+                "buffer size is not a multiple of the record size")
+        for name, field, column in zip(self.names, self.fields, columns):
+            if len(buffer(column)) < count * field.get_size():
+                raise ValueError("column '%s' is too small" % name)
+        return count
+
+    def decode(self, records, columns):
+        """Unpack all records in the buffer `records' into `columns', a
+        sequence of buffers in field order. Returns the number of records.
+        """
+        count = self._count(records, columns)
+        self.decoder.apply_([records] + list(columns) + [count])
+        return count
+
+    def encode(self, columns, records):
+        """Pack the values in `columns' into the buffer `records', which
+        determines the number of records. Returns the number of records.
+        """
+        count = self._count(records, columns)
+        self.encoder.apply_(list(columns) + [records, count])
+        return count
+
+def compile(struct_type, byteorder="native", context=None, unroll=4):
+    """Compile a Codec for records laid out as `struct_type'.
+
+    `byteorder' is the byte order of the records, one of "native", "little" or
+    "big". Fields of a different byte order are swapped while being decoded
+    or encoded. All fields must be of primitive numeric types. If `context' is
+    None, a new jit.Context is created for the functions.
+    """
+    if not struct_type.is_struct():
+        raise TypeError("struct_type must be a struct type")
+    if byteorder not in BYTEORDERS:
+        raise ValueError("byteorder must be one of %s" % ", ".join(BYTEORDERS))
+    if unroll < 1:
+        raise ValueError("unroll must be at least 1")
+    swap = byteorder not in ("native", sys.byteorder)
+
+    record_size = struct_type.get_size()
+    fields = []
+    for i in range(struct_type.num_fields()):
+        field = struct_type.get_field(i).remove_tags()
+        size = field.get_size()
+        if (not field.is_primitive() or field.is_pointer() or
+                field.get_kind() == TYPE_VOID):
+            raise TypeError("field %d is not of a numeric type" % i)
+        if swap and size > 1 and size not in _UNSIGNED_TYPES:
+            raise TypeError("cannot swap the bytes of field %d" % i)
+        fields.append((field, struct_type.get_offset(i), size))
+
+    def copy_field(function, source, source_offset, dest, dest_offset,
+                   field, size):
+        if swap and size > 1:
+            type_ = _UNSIGNED_TYPES[size]
+            value = _byteswap(function, Insn.load_relative(
+                function, source, source_offset, type_), type_)
+        else:
+            type_ = field
+            value = Insn.load_relative(function, source, source_offset, type_)
+        Insn.store_relative(function, dest, dest_offset, value)
+
+    column_pointer_types = [field.create_pointer() for field, _, _ in fields]
+    if context is None:
+        context = Context()
+
+    signature = Type.create_signature(
+        ABI_CDECL, Type.VOID,
+        [Type.VOID_PTR] + column_pointer_types + [Type.NINT])
+    decoder = Function(context, signature)
+    records = _local_copy(decoder, decoder.value_get_param(0))
+    columns = [_local_copy(decoder, decoder.value_get_param(i + 1))
+               for i in range(len(fields))]
+    count = decoder.value_get_param(len(fields) + 1)
+
+    def emit(k):
+        for column, (field, offset, size) in zip(columns, fields):
+            copy_field(decoder, records, k * record_size + offset,
+                       column, k * size, field, size)
+
+    def advance(num_records):
+        _advance(decoder, records, num_records * record_size)
+        for column, (_, _, size) in zip(columns, fields):
+            _advance(decoder, column, num_records * size)
+
+    _unrolled_loop(decoder, count, unroll, emit, advance)
+    decoder.insn_return(None)
+    decoder.compile_()
+
+    signature = Type.create_signature(
+        ABI_CDECL, Type.VOID,
+        column_pointer_types + [Type.VOID_PTR, Type.NINT])
+    encoder = Function(context, signature)
+    columns = [_local_copy(encoder, encoder.value_get_param(i))
+               for i in range(len(fields))]
+    records = _local_copy(encoder, encoder.value_get_param(len(fields)))
+    count = encoder.value_get_param(len(fields) + 1)
+
+    def emit(k):
+        for column, (field, offset, size) in zip(columns, fields):
+            copy_field(encoder, column, k * size, records,
+                       k * record_size + offset, field, size)
+
+    def advance(num_records):
+        _advance(encoder, records, num_records * record_size)
+        for column, (_, _, size) in zip(columns, fields):
+            _advance(encoder, column, num_records * size)
+
+    _unrolled_loop(encoder, count, unroll, emit, advance)
+    encoder.insn_return(None)
+    encoder.compile_()
+
+    return Codec(struct_type, byteorder, decoder, encoder)
@@ -0,0 +1,564 @@
+# python-libjit, Copyright 2014 Niklas Koep
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Generators for compiled kernels operating on arrays of primitive values.
+
+Arrays are passed to the generated functions as raw pointers along with an
+element count of type `jit.Type.NINT'.
+"""
+
+import inspect
+import sys
+
+from _jit import ABI_CDECL, Array, Function, Insn, Label, Type, Value
+
+DTYPES = {
+    "int8": Type.SBYTE,
+    "uint8": Type.UBYTE,
+    "int16": Type.SHORT,
+    "uint16": Type.USHORT,
+    "int32": Type.INT,
+    "uint32": Type.UINT,
+    "int64": Type.LONG,
+    "uint64": Type.ULONG,
+    "float32": Type.FLOAT32,
+    "float64": Type.FLOAT64
+}
+
+# Smallest and largest value of each integer dtype, which serve as the
+# identities of max and min reductions. The maxima of unsigned types are given
+# as -1, which wraps around to the right value when converted.
+_INTEGER_LIMITS = {
+    Type.SBYTE: (-2 ** 7, 2 ** 7 - 1),
+    Type.UBYTE: (0, -1),
+    Type.SHORT: (-2 ** 15, 2 ** 15 - 1),
+    Type.USHORT: (0, -1),
+    Type.INT: (-2 ** 31, 2 ** 31 - 1),
+    Type.UINT: (0, -1),
+    Type.LONG: (-2 ** 63, 2 ** 63 - 1),
+    Type.ULONG: (0, -1)
+}
+
+_FLOAT_TYPES = (Type.FLOAT32, Type.FLOAT64, Type.NFLOAT)
+
+def _resolve_dtype(dtype):
+    if isinstance(dtype, Type):
+        return dtype
+    try:
+        return DTYPES[dtype]
+    except KeyError:
+        raise ValueError("unknown dtype '%s'" % dtype)
+
+def _check_unroll(unroll):
+    if unroll < 1:
+        raise ValueError("unroll must be at least 1")
+
+def _constant(function, type_, value):
+    # 64-bit values do not fit a native int on targets with a 32-bit long.
+    if type_ in (Type.LONG, Type.ULONG) and not isinstance(value, float):
+        return Value.create_long_constant(function, type_, value)
+    if isinstance(value, float):
+        constant = Value.create_float64_constant(function, Type.FLOAT64, value)
+    else:
+        constant = Value.create_nint_constant(function, Type.NINT, value)
+    return Insn.convert(function, constant, type_, False)
+
+def _local_copy(function, value):
+    local = Value.create(function, value.get_type())
+    Insn.store(function, local, value)
+    return local
+
+def _advance(function, pointer, offset):
+    Insn.store(function, pointer, Insn.add_relative(function, pointer, offset))
+
+def _unrolled_loop(function, count, unroll, emit, advance):
+    """Emit a loop over `count' elements which calls `emit(k)' for the k-th
+    element of a block of `unroll' elements and `advance(num_elements)' after
+    each block. Pointers are thus only bumped once per block while the elements
+    inside a block are addressed with constant offsets. The trailing elements
+    are handled by a scalar tail loop.
+    """
+    if unroll > 1:
+        @function.loop(0, count - (unroll - 1), step=unroll)
+        def main(i):
+            for k in range(unroll):
+                emit(k)
+            advance(unroll)
+
+    @function.loop(0, count % unroll if unroll > 1 else count)
+    def tail(i):
+        emit(0)
+        advance(1)
+
+def elementwise(context, expression, dtypes, out, unroll=4):
+    """Compile a kernel applying `expression' to each element of its inputs.
+
+    The names of the positional arguments of `expression' name the inputs, and
+    `dtypes' maps each of them to a jit.Type or a key of `DTYPES'. `out' is
+    the dtype of the result. The returned jit.Function takes one pointer per
+    input (in the order of the arguments of `expression'), a pointer to the
+    output array and the number of elements, and stores `expression(**inputs)'
+    into each output element. Data-dependent choices inside `expression'
+    should use jit.Function.select, which is available through the
+    get_function method of the inputs, rather than branches.
+    """
+    argspec = inspect.getargspec(expression)
+    if (argspec.varargs is not None or argspec.keywords is not None or
+            argspec.defaults is not None):
+        raise ValueError(
+            "expression must only accept positional arguments without "
+            "defaults")
+    names = argspec.args
+    if set(names) != set(dtypes):
+        raise ValueError("dtypes must map exactly the arguments of expression")
+    _check_unroll(unroll)
+
+    types = [_resolve_dtype(dtypes[name]) for name in names]
+    out_type = _resolve_dtype(out)
+    sizes = [type_.get_size() for type_ in types]
+    out_size = out_type.get_size()
+
+    params = [Type.VOID_PTR] * (len(names) + 1) + [Type.NINT]
+    signature = Type.create_signature(ABI_CDECL, Type.VOID, params)
+
+    function = Function(context, signature)
+    pointers = [_local_copy(function, function.value_get_param(i))
+                for i in range(len(names) + 1)]
+    out_pointer = pointers.pop()
+    count = function.value_get_param(len(names) + 1)
+
+    def emit(k):
+        inputs = {}
+        for name, pointer, type_, size in zip(names, pointers, types,
+                                              sizes):
+            inputs[name] = Insn.load_relative(
+                function, pointer, k * size, type_)
+        result = expression(**inputs)
+        if not isinstance(result, Value):
+            raise TypeError("expression must return a jit.Value")
+        result = Insn.convert(function, result, out_type, False)
+        Insn.store_relative(function, out_pointer, k * out_size, result)
+
+    def advance(num_elements):
+        for pointer, size in zip(pointers, sizes):
+            _advance(function, pointer, num_elements * size)
+        _advance(function, out_pointer, num_elements * out_size)
+
+    _unrolled_loop(function, count, unroll, emit, advance)
+    function.insn_return(None)
+
+    function.compile_()
+    return function
+
+def _identity(op, type_):
+    if op in ("sum", "dot", "count_if"):
+        return 0
+    if type_ in _FLOAT_TYPES:
+        infinity = float("inf")
+        return infinity if op == "min" else -infinity
+    try:
+        lower, upper = _INTEGER_LIMITS[type_]
+    except KeyError:
+        raise ValueError("cannot reduce values of type '%s'" % type_)
+    return upper if op == "min" else lower
+
+_REDUCTIONS = {
+    "sum": Insn.add,
+    "min": Insn.min,
+    "max": Insn.max
+}
+
+def reduce(context, op, dtype, accumulators=4, predicate=None):
+    """Compile a reduction over an array of `dtype' elements.
+
+    `op' is one of "sum", "min", "max", "dot" or "count_if". The returned
+    jit.Function takes a pointer to the input array (two for "dot") and the
+    number of elements. It returns a value of type `dtype', except for
+    "count_if" which returns the number of elements for which
+    `predicate(x)' is true as a jit.Type.NINT.
+
+    The work is spread over `accumulators' independent accumulators which are
+    combined once the loop is done. This breaks the dependency chain of a
+    single accumulator so that consecutive additions or comparisons can
+    execute in parallel.
+    """
+    if op not in ("sum", "min", "max", "dot", "count_if"):
+        raise ValueError("unknown reduction '%s'" % op)
+    if (op == "count_if") != (predicate is not None):
+        raise ValueError("a predicate is required for, and only for, count_if")
+    _check_unroll(accumulators)
+
+    type_ = _resolve_dtype(dtype)
+    size = type_.get_size()
+    result_type = Type.NINT if op == "count_if" else type_
+    identity = _identity(op, type_)
+    num_arrays = 2 if op == "dot" else 1
+
+    if op == "dot":
+        def update(function, acc, x, y):
+            return Insn.add(function, acc, Insn.mul(function, x, y))
+    elif op == "count_if":
+        def update(function, acc, x):
+            return Insn.add(function, acc,
+                            Insn.to_bool(function, predicate(x)))
+    else:
+        update = _REDUCTIONS[op]
+    combine = Insn.add if op in ("sum", "dot", "count_if") else _REDUCTIONS[op]
+
+    params = [Type.VOID_PTR] * num_arrays + [Type.NINT]
+    signature = Type.create_signature(ABI_CDECL, result_type, params)
+
+    function = Function(context, signature)
+    pointers = [_local_copy(function, function.value_get_param(i))
+                for i in range(num_arrays)]
+    count = function.value_get_param(num_arrays)
+    accs = [_local_copy(function,
+                        _constant(function, result_type, identity))
+            for i in range(accumulators)]
+
+    def emit(k):
+        elements = [Insn.load_relative(function, pointer, k * size, type_)
+                    for pointer in pointers]
+        value = update(function, accs[k], *elements)
+        Insn.store(function, accs[k],
+                   Insn.convert(function, value, result_type, False))
+
+    def advance(num_elements):
+        for pointer in pointers:
+            _advance(function, pointer, num_elements * size)
+
+    _unrolled_loop(function, count, accumulators, emit, advance)
+
+    # Combine the accumulators pairwise to keep the final dependency chain
+    # short as well.
+    while len(accs) > 1:
+        combined = [Insn.convert(function, combine(function, a, b),
+                                 result_type, False)
+                    for a, b in zip(accs[::2], accs[1::2])]
+        if len(accs) % 2:
+            combined.append(accs[-1])
+        accs = combined
+    function.insn_return(accs[0])
+
+    function.compile_()
+    return function
+
+_MASK64 = 2 ** 64 - 1
+
+def _u64(function, value):
+    return Value.create_long_constant(function, Type.ULONG, value & _MASK64)
+
+def _rotl64(function, x, r):
+    return ((x << _u64(function, r)) |
+            Insn.ushr(function, x, _u64(function, 64 - r)))
+
+def _shr64(function, x, r):
+    return Insn.ushr(function, x, _u64(function, r))
+
+def _to_u64(function, value):
+    return Insn.convert(function, value, Type.ULONG, False)
+
+def _load_u64(function, pointer, offset, size):
+    """Load `size' bytes at `offset' as an unsigned 64-bit integer."""
+    type_ = {1: Type.UBYTE, 4: Type.UINT, 8: Type.ULONG}[size]
+    return _to_u64(function, Insn.load_relative(function, pointer, offset,
+                                                 type_))
+
+def _fnv1a(function, pointer, key_size, seed):
+    h = _u64(function, 0xcbf29ce484222325)
+    prime = _u64(function, 0x100000001b3)
+    for offset in range(key_size):
+        h = _to_u64(function, h ^ _load_u64(function, pointer, offset, 1))
+        h = _to_u64(function, h * prime)
+    return h
+
+def _murmur(function, pointer, key_size, seed):
+    # MurmurHash64A
+    m = _u64(function, 0xc6a4a7935bd1e995)
+    h = _u64(function, seed ^ ((key_size * 0xc6a4a7935bd1e995) & _MASK64))
+    blocks, tail = divmod(key_size, 8)
+    for block in range(blocks):
+        k = _load_u64(function, pointer, 8 * block, 8)
+        k = _to_u64(function, k * m)
+        k = _to_u64(function, k ^ _shr64(function, k, 47))
+        k = _to_u64(function, k * m)
+        h = _to_u64(function, (h ^ k) * m)
+    if tail:
+        for i in range(tail):
+            byte = _load_u64(function, pointer, 8 * blocks + i, 1)
+            h = _to_u64(function, h ^ (byte << _u64(function, 8 * i)))
+        h = _to_u64(function, h * m)
+    h = _to_u64(function, h ^ _shr64(function, h, 47))
+    h = _to_u64(function, h * m)
+    return _to_u64(function, h ^ _shr64(function, h, 47))
+
+_XXH_PRIMES = (0x9e3779b185ebca87, 0xc2b2ae3d27d4eb4f, 0x165667b19e3779f9,
+               0x85ebca77c2b2ae63, 0x27d4eb2f165667c5)
+
+def _xxhash(function, pointer, key_size, seed):
+    # XXH64
+    p1, p2, p3, p4, p5 = [_u64(function, p) for p in _XXH_PRIMES]
+
+    def round_(acc, lane):
+        acc = _to_u64(function, acc + lane * p2)
+        return _to_u64(function, _rotl64(function, acc, 31) * p1)
+
+    offset = 0
+    if key_size >= 32:
+        accs = [_u64(function, seed + _XXH_PRIMES[0] + _XXH_PRIMES[1]),
+                _u64(function, seed + _XXH_PRIMES[1]),
+                _u64(function, seed),
+                _u64(function, seed - _XXH_PRIMES[0])]
+        while offset + 32 <= key_size:
+            accs = [round_(acc, _load_u64(function, pointer, offset + 8 * i, 8))
+                    for i, acc in enumerate(accs)]
+            offset += 32
+        h = _to_u64(function, (_rotl64(function, accs[0], 1) +
+                               _rotl64(function, accs[1], 7)) +
+                              (_rotl64(function, accs[2], 12) +
+                               _rotl64(function, accs[3], 18)))
+        for acc in accs:
+            h = _to_u64(function, h ^ round_(_u64(function, 0), acc))
+            h = _to_u64(function, h * p1 + p4)
+    else:
+        h = _u64(function, seed + _XXH_PRIMES[4])
+    h = _to_u64(function, h + _u64(function, key_size))
+
+    while offset + 8 <= key_size:
+        k = round_(_u64(function, 0), _load_u64(function, pointer, offset, 8))
+        h = _to_u64(function, _rotl64(function, h ^ k, 27) * p1 + p4)
+        offset += 8
+    if offset + 4 <= key_size:
+        k = _to_u64(function, _load_u64(function, pointer, offset, 4) * p1)
+        h = _to_u64(function, _rotl64(function, h ^ k, 23) * p2 + p3)
+        offset += 4
+    while offset < key_size:
+        k = _to_u64(function, _load_u64(function, pointer, offset, 1) * p5)
+        h = _to_u64(function, _rotl64(function, h ^ k, 11) * p1)
+        offset += 1
+
+    h = _to_u64(function, h ^ _shr64(function, h, 33))
+    h = _to_u64(function, h * p2)
+    h = _to_u64(function, h ^ _shr64(function, h, 29))
+    h = _to_u64(function, h * p3)
+    return _to_u64(function, h ^ _shr64(function, h, 32))
+
+HASH_ALGORITHMS = {
+    "fnv1a": _fnv1a,
+    "murmur": _murmur,
+    "xxhash": _xxhash
+}
+
+def hash(context, key_size, algorithm="fnv1a", seed=0, batch=False):
+    """Compile a 64-bit hash function for keys of exactly `key_size' bytes.
+
+    `algorithm' is one of "fnv1a" (FNV-1a), "murmur" (MurmurHash64A) or
+    "xxhash" (XXH64); `seed' is ignored by FNV-1a. Multi-byte words of the key
+    are read in native byte order. The code is fully unrolled for the key
+    size, so it contains neither loops nor branches.
+
+    The returned jit.Function takes a pointer to a key and returns its hash as
+    a jit.Type.ULONG. With `batch', it instead takes a pointer to an array of
+    keys, a pointer to an array of jit.Type.ULONG receiving the hashes and the
+    number of keys.
+    """
+    if key_size < 1:
+        raise ValueError("key_size must be positive")
+    try:
+        emit_hash = HASH_ALGORITHMS[algorithm]
+    except KeyError:
+        raise ValueError("unknown hash algorithm '%s'" % algorithm)
+    seed &= _MASK64
+
+    if batch:
+        params = [Type.VOID_PTR, Type.ULONG.create_pointer(), Type.NINT]
+        signature = Type.create_signature(ABI_CDECL, Type.VOID, params)
+    else:
+        signature = Type.create_signature(ABI_CDECL, Type.ULONG,
+                                          [Type.VOID_PTR])
+
+    function = Function(context, signature)
+    if batch:
+        keys = _local_copy(function, function.value_get_param(0))
+        out = function.value_get_param(1)
+        count = function.value_get_param(2)
+
+        @function.loop(0, count)
+        def body(i):
+            Insn.store_elem(function, out, i,
+                            emit_hash(function, keys, key_size, seed))
+            _advance(function, keys, key_size)
+
+        function.insn_return(None)
+    else:
+        function.insn_return(emit_hash(
+            function, function.value_get_param(0), key_size, seed))
+
+    function.compile_()
+    return function
+
+_CRC32_POLYNOMIAL = 0xedb88320
+_crc32_tables = None
+
+def _get_crc32_tables():
+    """Return the eight lookup tables of slicing-by-8 CRC32 as one array.
+
+    Table k maps a byte to its CRC after being followed by k zero bytes. The
+    array is created once and never freed, so compiled kernels can refer to it
+    by its address.
+    """
+    global _crc32_tables
+    if _crc32_tables is None:
+        tables = [[]]
+        for byte in range(256):
+            crc = byte
+            for bit in range(8):
+                crc = (crc >> 1) ^ (_CRC32_POLYNOMIAL if crc & 1 else 0)
+            tables[0].append(crc)
+        for k in range(1, 8):
+            tables.append([(crc >> 8) ^ tables[0][crc & 0xff]
+                           for crc in tables[k - 1]])
+        array = Array(Type.UINT, 8 * 256)
+        array[:] = sum(tables, [])
+        _crc32_tables = array
+    return _crc32_tables
+
+def _checksum_signature():
+    return Type.create_signature(ABI_CDECL, Type.UINT,
+                                 [Type.VOID_PTR, Type.NUINT, Type.UINT])
+
+def crc32(context):
+    """Compile a CRC32 kernel compatible with zlib.crc32.
+
+    The returned jit.Function takes a pointer to the data, its length in bytes
+    and the CRC of any preceding data (0 to start a new checksum), and returns
+    the updated CRC as a jit.Type.UINT. Eight bytes are processed at a time
+    with the slicing-by-8 algorithm. Since the kernel does not call back into
+    Python, it may be applied with `release_gil' set.
+    """
+    tables = _get_crc32_tables()
+    table_size = 256 * Type.UINT.get_size()
+    # Slicing-by-8 combines two 32-bit words loaded in little-endian order.
+    sliced = sys.byteorder == "little"
+
+    function = Function(context, _checksum_signature())
+    data = _local_copy(function, function.value_get_param(0))
+    length = function.value_get_param(1)
+    crc = _local_copy(function, ~function.value_get_param(2))
+    byte_mask = _constant(function, Type.UINT, 0xff)
+
+    def table(k):
+        return Value.create_nint_constant(
+            function, Type.VOID_PTR, tables.get_address() + k * table_size)
+
+    def lookup(k, index):
+        return Insn.load_elem(function, table(k), index & byte_mask,
+                              Type.UINT)
+
+    def shift(value, bits):
+        return Insn.ushr(function, value,
+                         _constant(function, Type.UINT, bits))
+
+    if sliced:
+        @function.loop(0, Insn.ushr(function, length,
+                                    _constant(function, Type.NUINT, 3)))
+        def words(i):
+            one = Insn.load_relative(function, data, 0, Type.UINT) ^ crc
+            two = Insn.load_relative(function, data, 4, Type.UINT)
+            value = lookup(7, one)
+            for k, (word, bits) in enumerate(
+                    [(one, 8), (one, 16), (one, 24), (two, 0), (two, 8),
+                     (two, 16), (two, 24)]):
+                value = value ^ lookup(6 - k, shift(word, bits))
+            Insn.store(function, crc,
+                       Insn.convert(function, value, Type.UINT, False))
+            _advance(function, data, 8)
+        remainder = length & _constant(function, Type.NUINT, 7)
+    else:
+        remainder = length
+
+    @function.loop(0, remainder)
+    def tail(i):
+        byte = Insn.load_relative(function, data, 0, Type.UBYTE)
+        value = shift(crc, 8) ^ lookup(0, crc ^ byte)
+        Insn.store(function, crc,
+                   Insn.convert(function, value, Type.UINT, False))
+        _advance(function, data, 1)
+
+    function.insn_return(
+        Insn.convert(function, ~crc, Type.UINT, False))
+
+    function.compile_()
+    return function
+
+_ADLER32_MODULUS = 65521
+# Largest number of bytes after which the sums of Adler-32 cannot overflow 32
+# bits yet, as in zlib.
+_ADLER32_NMAX = 5552
+
+def adler32(context, unroll=8):
+    """Compile an Adler-32 kernel compatible with zlib.adler32.
+
+    The returned jit.Function takes a pointer to the data, its length in bytes
+    and the checksum of any preceding data (1 to start a new checksum), and
+    returns the updated checksum as a jit.Type.UINT. The modulo reductions are
+    deferred to the end of blocks which are short enough for the sums not to
+    overflow.
+    """
+    _check_unroll(unroll)
+
+    function = Function(context, _checksum_signature())
+    data = _local_copy(function, function.value_get_param(0))
+    remaining = _local_copy(
+        function, Insn.convert(function, function.value_get_param(1),
+                               Type.NUINT, False))
+    adler = function.value_get_param(2)
+    mask = _constant(function, Type.UINT, 0xffff)
+    modulus = _constant(function, Type.UINT, _ADLER32_MODULUS)
+    a = _local_copy(function, adler & mask)
+    b = _local_copy(function, Insn.ushr(
+        function, adler, _constant(function, Type.UINT, 16)) & mask)
+    block = Value.create(function, Type.NUINT)
+    top, done = Label(), Label()
+
+    Insn.label(function, top)
+    Insn.branch_if_not(function, remaining, done)
+    Insn.store(function, block, Insn.min(
+        function, remaining,
+        _constant(function, Type.NUINT, _ADLER32_NMAX)))
+
+    @function.loop(0, block, unroll=unroll)
+    def body(i):
+        byte = Insn.load_elem(function, data, i, Type.UBYTE)
+        Insn.store(function, a, Insn.convert(
+            function, a + byte, Type.UINT, False))
+        Insn.store(function, b, Insn.convert(
+            function, b + a, Type.UINT, False))
+
+    Insn.store(function, a, Insn.convert(
+        function, Insn.rem(function, a, modulus), Type.UINT, False))
+    Insn.store(function, b, Insn.convert(
+        function, Insn.rem(function, b, modulus), Type.UINT, False))
+    Insn.store(function, data, Insn.add(function, data, block))
+    Insn.store(function, remaining, Insn.convert(
+        function, remaining - block, Type.NUINT, False))
+    Insn.branch(function, top)
+
+    Insn.label(function, done)
+    function.insn_return(Insn.convert(
+        function, (b << _constant(function, Type.UINT, 16)) | a,
+        Type.UINT, False))
+
+    function.compile_()
+    return function
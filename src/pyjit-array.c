@@ -0,0 +1,572 @@
+/* python-libjit, Copyright 2014 Niklas Koep
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pyjit-array.h"
+
+#include "pyjit-marshal.h"
+#include "pyjit-type.h"
+
+PyDoc_STRVAR(array_doc,
+"Array(type, n, alignment=64)\n\n"
+"Zero-initialized array of `n' elements of the jit.Type `type' whose storage\n"
+"is aligned to `alignment' bytes. Arrays support the buffer protocol and are\n"
+"passed to pointer parameters of JIT'ed functions directly. Slicing an array\n"
+"yields a view sharing its memory.");
+
+/* Set the struct module format describing elements of type `type'. */
+static int
+_array_set_format(PyJitArray *self, jit_type_t type)
+{
+    const char *format;
+    int kind = jit_type_get_kind(type);
+
+    switch (kind) {
+    case JIT_TYPE_SBYTE:
+        format = "b";
+        break;
+    case JIT_TYPE_UBYTE:
+        format = "B";
+        break;
+    case JIT_TYPE_SHORT:
+        format = "h";
+        break;
+    case JIT_TYPE_USHORT:
+        format = "H";
+        break;
+    case JIT_TYPE_INT:
+        format = "i";
+        break;
+    case JIT_TYPE_UINT:
+        format = "I";
+        break;
+    case JIT_TYPE_NINT:
+        format = sizeof(jit_nint) == sizeof(long) ? "l" : "q";
+        break;
+    case JIT_TYPE_NUINT:
+        format = sizeof(jit_nuint) == sizeof(unsigned long) ? "L" : "Q";
+        break;
+    case JIT_TYPE_LONG:
+        format = "q";
+        break;
+    case JIT_TYPE_ULONG:
+        format = "Q";
+        break;
+    case JIT_TYPE_FLOAT32:
+        format = "f";
+        break;
+    case JIT_TYPE_FLOAT64:
+        format = "d";
+        break;
+    case JIT_TYPE_NFLOAT:
+        format = sizeof(jit_nfloat) == sizeof(double) ? "d" : "g";
+        break;
+    case JIT_TYPE_PTR:
+    case JIT_TYPE_SIGNATURE:
+        format = "P";
+        break;
+    case JIT_TYPE_STRUCT:
+    case JIT_TYPE_UNION:
+        /* Aggregates are exposed as opaque byte strings of their size. */
+        PyOS_snprintf(self->format, sizeof(self->format), "%lus",
+                      (unsigned long)jit_type_get_size(type));
+        return 0;
+    default:
+        PyErr_Format(PyExc_TypeError, "cannot create arrays of kind %d",
+                     kind);
+        return -1;
+    }
+    strcpy(self->format, format);
+    return 0;
+}
+
+static jit_type_t
+_array_get_jit_type(PyJitArray *self)
+{
+    return ((PyJitType *)self->type)->type;
+}
+
+/* Slot implementations */
+
+static void
+array_dealloc(PyJitArray *self)
+{
+    if (self->weakreflist)
+        PyObject_ClearWeakRefs((PyObject *)self);
+
+    /* Views only hold a reference to the array owning their memory. */
+    PyMem_Free(self->allocation);
+    Py_XDECREF(self->base);
+    Py_XDECREF(self->type);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+array_repr(PyJitArray *self)
+{
+    if (!self->data)
+        return PyString_FromFormat("<jit.Array at %p>", self);
+    return PyString_FromFormat("<jit.Array of %zd '%s' at %p>",
+                               self->length, self->format, self->data);
+}
+
+static int
+array_init(PyJitArray *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *type = NULL;
+    PyJitType *jit_type;
+    Py_ssize_t n, alignment = 64, itemsize;
+    size_t size;
+    static char *kwlist[] = { "type", "n", "alignment", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "On|n:Array", kwlist,
+                                     &type, &n, &alignment))
+        return -1;
+
+    if (self->data) {
+        PyErr_SetString(PyExc_ValueError, "array is already initialized");
+        return -1;
+    }
+
+    jit_type = PyJitType_Cast(type);
+    if (!jit_type) {
+        pyjit_raise_type_error("type", pyjit_type_get_pytype(), type);
+        return -1;
+    }
+    if (n < 0) {
+        PyErr_SetString(PyExc_ValueError, "n must not be negative");
+        return -1;
+    }
+    if (alignment <= 0 || (alignment & (alignment - 1))) {
+        PyErr_SetString(PyExc_ValueError,
+                        "alignment must be a positive power of two");
+        return -1;
+    }
+
+    itemsize = (Py_ssize_t)jit_type_get_size(jit_type->type);
+    if (itemsize == 0) {
+        PyErr_SetString(PyExc_ValueError, "type must not be empty");
+        return -1;
+    }
+    if (_array_set_format(self, jit_type_remove_tags(jit_type->type)) < 0)
+        return -1;
+    if (n > (PY_SSIZE_T_MAX - alignment) / itemsize) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    /* Over-allocate so that the data can be moved up to the next multiple of
+     * the alignment.
+     */
+    size = (size_t)(n * itemsize);
+    self->allocation = PyMem_Malloc(size + (size_t)alignment);
+    if (!self->allocation) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    self->data = (char *)(((jit_nuint)self->allocation + alignment - 1) &
+                          ~(jit_nuint)(alignment - 1));
+    memset(self->data, 0, size);
+
+    Py_INCREF(type);
+    self->type = type;
+    self->length = n;
+    self->itemsize = itemsize;
+    self->stride = itemsize;
+    return 0;
+}
+
+/* Sequence and mapping protocols */
+
+static Py_ssize_t
+array_length(PyJitArray *self)
+{
+    if (PyJitArray_Verify(self) < 0)
+        return -1;
+    return self->length;
+}
+
+static PyObject *
+array_item(PyJitArray *self, Py_ssize_t i)
+{
+    if (PyJitArray_Verify(self) < 0)
+        return NULL;
+    if (i < 0 || i >= self->length) {
+        PyErr_SetString(PyExc_IndexError, "array index out of range");
+        return NULL;
+    }
+    return pyjit_marshal_arg_to_py(_array_get_jit_type(self),
+                                   self->data + i * self->stride);
+}
+
+static PyObject *
+_array_view(PyJitArray *self, Py_ssize_t start, Py_ssize_t step,
+            Py_ssize_t length)
+{
+    PyJitArray *view;
+
+    view = (PyJitArray *)PyType_GenericNew(Py_TYPE(self), NULL, NULL);
+    if (!view)
+        return NULL;
+
+    view->base = self->base ? self->base : (PyObject *)self;
+    Py_INCREF(view->base);
+    Py_INCREF(self->type);
+    view->type = self->type;
+    view->data = self->data + start * self->stride;
+    view->length = length;
+    view->itemsize = self->itemsize;
+    view->stride = self->stride * step;
+    strcpy(view->format, self->format);
+    return (PyObject *)view;
+}
+
+static int
+_array_get_index(PyJitArray *self, PyObject *item, Py_ssize_t *index)
+{
+    Py_ssize_t i = PyNumber_AsSsize_t(item, PyExc_IndexError);
+
+    if (i == -1 && PyErr_Occurred())
+        return -1;
+    if (i < 0)
+        i += self->length;
+    if (i < 0 || i >= self->length) {
+        PyErr_SetString(PyExc_IndexError, "array index out of range");
+        return -1;
+    }
+    *index = i;
+    return 0;
+}
+
+static PyObject *
+array_subscript(PyJitArray *self, PyObject *item)
+{
+    Py_ssize_t i, start, stop, step, length;
+
+    if (PyJitArray_Verify(self) < 0)
+        return NULL;
+
+    if (PySlice_Check(item)) {
+        if (PySlice_GetIndicesEx((PySliceObject *)item, self->length, &start,
+                                 &stop, &step, &length) < 0)
+            return NULL;
+        return _array_view(self, start, step, length);
+    }
+    if (PyIndex_Check(item)) {
+        if (_array_get_index(self, item, &i) < 0)
+            return NULL;
+        return array_item(self, i);
+    }
+    PyErr_Format(PyExc_TypeError,
+                 "array indices must be integers or slices, not %.100s",
+                 Py_TYPE(item)->tp_name);
+    return NULL;
+}
+
+static int
+array_ass_subscript(PyJitArray *self, PyObject *item, PyObject *value)
+{
+    Py_ssize_t i, start, stop, step, length;
+    jit_type_t type;
+
+    if (PyJitArray_Verify(self) < 0)
+        return -1;
+    if (!value) {
+        PyErr_SetString(PyExc_TypeError,
+                        "array doesn't support item deletion");
+        return -1;
+    }
+    type = _array_get_jit_type(self);
+
+    if (PySlice_Check(item)) {
+        PyObject *seq;
+        int r = 0;
+
+        if (PySlice_GetIndicesEx((PySliceObject *)item, self->length, &start,
+                                 &stop, &step, &length) < 0)
+            return -1;
+        seq = PySequence_Fast(value, "can only assign a sequence to a slice");
+        if (!seq)
+            return -1;
+        if (PySequence_Fast_GET_SIZE(seq) != length) {
+            PyErr_Format(PyExc_ValueError,
+                         "cannot assign %zd values to a slice of length %zd",
+                         PySequence_Fast_GET_SIZE(seq), length);
+            r = -1;
+        }
+        for (i = 0; r == 0 && i < length; i++) {
+            r = pyjit_marshal_arg_into(
+                PySequence_Fast_GET_ITEM(seq, i), type,
+                self->data + (start + i * step) * self->stride);
+        }
+        Py_DECREF(seq);
+        return r;
+    }
+    if (PyIndex_Check(item)) {
+        if (_array_get_index(self, item, &i) < 0)
+            return -1;
+        return pyjit_marshal_arg_into(value, type,
+                                      self->data + i * self->stride);
+    }
+    PyErr_Format(PyExc_TypeError,
+                 "array indices must be integers or slices, not %.100s",
+                 Py_TYPE(item)->tp_name);
+    return -1;
+}
+
+static PySequenceMethods array_as_sequence = {
+    (lenfunc)array_length,          /* sq_length */
+    0,                              /* sq_concat */
+    0,                              /* sq_repeat */
+    (ssizeargfunc)array_item        /* sq_item */
+};
+
+static PyMappingMethods array_as_mapping = {
+    (lenfunc)array_length,              /* mp_length */
+    (binaryfunc)array_subscript,        /* mp_subscript */
+    (objobjargproc)array_ass_subscript  /* mp_ass_subscript */
+};
+
+/* Buffer protocols
+ *
+ * Views with a step other than 1 are only exported through the new-style
+ * buffer protocol to consumers which accept strided buffers.
+ */
+
+static int
+_array_is_contiguous(PyJitArray *self)
+{
+    return self->stride == self->itemsize;
+}
+
+static Py_ssize_t
+_array_get_segment(PyJitArray *self, Py_ssize_t segment, void **ptr)
+{
+    if (PyJitArray_Verify(self) < 0)
+        return -1;
+    if (segment != 0) {
+        PyErr_SetString(PyExc_SystemError,
+                        "accessing non-existent array segment");
+        return -1;
+    }
+    if (!_array_is_contiguous(self)) {
+        PyErr_SetString(PyExc_BufferError, "array is not contiguous");
+        return -1;
+    }
+    *ptr = self->data;
+    return self->length * self->itemsize;
+}
+
+static Py_ssize_t
+array_getreadbuffer(PyJitArray *self, Py_ssize_t segment, void **ptr)
+{
+    return _array_get_segment(self, segment, ptr);
+}
+
+static Py_ssize_t
+array_getwritebuffer(PyJitArray *self, Py_ssize_t segment, void **ptr)
+{
+    return _array_get_segment(self, segment, ptr);
+}
+
+static Py_ssize_t
+array_getsegcount(PyJitArray *self, Py_ssize_t *lenp)
+{
+    if (lenp)
+        *lenp = self->length * self->itemsize;
+    return 1;
+}
+
+static Py_ssize_t
+array_getcharbuffer(PyJitArray *self, Py_ssize_t segment, char **ptr)
+{
+    return _array_get_segment(self, segment, (void **)ptr);
+}
+
+static int
+array_getbuffer(PyJitArray *self, Py_buffer *view, int flags)
+{
+    view->obj = NULL;
+    if (PyJitArray_Verify(self) < 0)
+        return -1;
+
+    if (!_array_is_contiguous(self) &&
+            ((flags & PyBUF_STRIDES) != PyBUF_STRIDES ||
+             (flags & (PyBUF_ANY_CONTIGUOUS & ~PyBUF_STRIDES)) ||
+             (flags & (PyBUF_C_CONTIGUOUS & ~PyBUF_STRIDES)) ||
+             (flags & (PyBUF_F_CONTIGUOUS & ~PyBUF_STRIDES)))) {
+        PyErr_SetString(PyExc_BufferError, "array is not contiguous");
+        return -1;
+    }
+
+    view->buf = self->data;
+    view->len = self->length * self->itemsize;
+    view->readonly = 0;
+    view->itemsize = self->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? self->format : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) == PyBUF_ND ? &self->length : NULL;
+    view->strides =
+        (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &self->stride : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    Py_INCREF(self);
+    view->obj = (PyObject *)self;
+    return 0;
+}
+
+static PyBufferProcs array_as_buffer = {
+    (readbufferproc)array_getreadbuffer,    /* bf_getreadbuffer */
+    (writebufferproc)array_getwritebuffer,  /* bf_getwritebuffer */
+    (segcountproc)array_getsegcount,        /* bf_getsegcount */
+    (charbufferproc)array_getcharbuffer,    /* bf_getcharbuffer */
+    (getbufferproc)array_getbuffer,         /* bf_getbuffer */
+    0                                       /* bf_releasebuffer */
+};
+
+/* Regular methods */
+
+static PyObject *
+array_get_type(PyJitArray *self)
+{
+    if (PyJitArray_Verify(self) < 0)
+        return NULL;
+    Py_INCREF(self->type);
+    return self->type;
+}
+
+static PyObject *
+array_get_address(PyJitArray *self)
+{
+    if (PyJitArray_Verify(self) < 0)
+        return NULL;
+    return PyLong_FromVoidPtr(self->data);
+}
+
+static PyObject *
+array_is_contiguous(PyJitArray *self)
+{
+    if (PyJitArray_Verify(self) < 0)
+        return NULL;
+    return PyBool_FromLong(_array_is_contiguous(self));
+}
+
+static PyMethodDef array_methods[] = {
+    PYJIT_METHOD_NOARGS(array, get_type),
+    PYJIT_METHOD_NOARGS(array, get_address),
+    PYJIT_METHOD_NOARGS(array, is_contiguous),
+    { NULL } /* Sentinel */
+};
+
+static PyTypeObject PyJitArray_Type = {
+    PyObject_HEAD_INIT(NULL)
+    0,                                      /* ob_size */
+    "jit.Array",                            /* tp_name */
+    sizeof(PyJitArray),                     /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor)array_dealloc,              /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    (reprfunc)array_repr,                   /* tp_repr */
+    0,                                      /* tp_as_number */
+    &array_as_sequence,                     /* tp_as_sequence */
+    &array_as_mapping,                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    &array_as_buffer,                       /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER, /* tp_flags */
+    array_doc,                              /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    offsetof(PyJitArray, weakreflist),      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    array_methods,                          /* tp_methods */
+    0,                                      /* tp_members */
+    0,                                      /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    (initproc)array_init,                   /* tp_init */
+    0,                                      /* tp_alloc */
+    PyType_GenericNew                       /* tp_new */
+};
+
+int
+pyjit_array_init(PyObject *module)
+{
+    if (PyType_Ready(&PyJitArray_Type) < 0)
+        return -1;
+
+    Py_INCREF(&PyJitArray_Type);
+    PyModule_AddObject(module, "Array", (PyObject *)&PyJitArray_Type);
+
+    return 0;
+}
+
+const PyTypeObject *
+pyjit_array_get_pytype(void)
+{
+    return &PyJitArray_Type;
+}
+
+int
+PyJitArray_Check(PyObject *o)
+{
+    return PyObject_IsInstance(o, (PyObject *)&PyJitArray_Type);
+}
+
+PyJitArray *
+PyJitArray_Cast(PyObject *o)
+{
+    int r = PyJitArray_Check(o);
+    if (r == 1)
+        return (PyJitArray *)o;
+    else if (r < 0 && PyErr_Occurred())
+        PyErr_Clear();
+    return NULL;
+}
+
+int
+PyJitArray_Verify(PyJitArray *o)
+{
+    if (!o->data) {
+        PyErr_SetString(PyExc_ValueError, "array is not initialized");
+        return -1;
+    }
+    return 0;
+}
+
+PyJitArray *
+PyJitArray_CastAndVerify(PyObject *o)
+{
+    PyJitArray *array = PyJitArray_Cast(o);
+    if (!array) {
+        PyErr_Format(
+            PyExc_TypeError, "expected instance of %.100s, not %.100s",
+            pyjit_array_get_pytype()->tp_name, Py_TYPE(o)->tp_name);
+        return NULL;
+    }
+    if (PyJitArray_Verify(array) < 0)
+        return NULL;
+    return array;
+}
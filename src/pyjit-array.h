@@ -0,0 +1,41 @@
+/* python-libjit, Copyright 2014 Niklas Koep
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ___PYJIT_ARRAY_H__
+#define ___PYJIT_ARRAY_H__
+
+#include "pyjit-common.h"
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *type;         /* jit.Type of the elements */
+    PyObject *base;         /* array owning the memory of a view, or NULL */
+    void *allocation;       /* unaligned block owned by the array */
+    char *data;             /* first element */
+    Py_ssize_t length;
+    Py_ssize_t itemsize;
+    Py_ssize_t stride;      /* distance between elements in bytes */
+    char format[24];        /* struct module format of the elements */
+    PyObject *weakreflist;
+} PyJitArray;
+
+int pyjit_array_init(PyObject *module);
+const PyTypeObject *pyjit_array_get_pytype(void);
+int PyJitArray_Check(PyObject *o);
+PyJitArray *PyJitArray_Cast(PyObject *o);
+int PyJitArray_Verify(PyJitArray *o);
+PyJitArray *PyJitArray_CastAndVerify(PyObject *o);
+
+#endif /* ___PYJIT_ARRAY_H__ */
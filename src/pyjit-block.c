@@ -0,0 +1,318 @@
+/* python-libjit, Copyright 2014 Niklas Koep
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pyjit-block.h"
+
+#include "pyjit-context.h"
+#include "pyjit-function.h"
+#include "pyjit-insn.h"
+#include "pyjit-label.h"
+
+PyDoc_STRVAR(block_doc, "Wrapper class for jit_block_t");
+
+static PyObject *block_cache = NULL;
+
+/* Slot implementations */
+
+static void
+block_dealloc(PyJitBlock *self)
+{
+    if (self->weakreflist)
+        PyObject_ClearWeakRefs((PyObject *)self);
+
+    if (self->block) {
+        PYJIT_BEGIN_ALLOW_EXCEPTION
+        if (pyjit_weak_cache_delitem(block_cache, (long)self->block) < 0) {
+            PYJIT_TRACE("this shouldn't have happened");
+            abort();
+        }
+        PYJIT_END_ALLOW_EXCEPTION
+    }
+
+    Py_XDECREF(self->function);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+PYJIT_REPR_GENERIC(block_repr, PyJitBlock, block)
+
+PYJIT_HASH_GENERIC(block_hash, PyJitBlock, PyJitBlock_Verify, block)
+
+/* Iterating over a block yields its instructions in order. */
+static PyObject *
+block_iter(PyJitBlock *self)
+{
+    PyObject *insns, *iter;
+    jit_insn_iter_t insn_iter;
+    jit_insn_t insn;
+
+    if (PyJitBlock_Verify(self) < 0)
+        return NULL;
+
+    insns = PyList_New(0);
+    if (!insns)
+        return NULL;
+
+    jit_insn_iter_init(&insn_iter, self->block);
+    while ((insn = jit_insn_iter_next(&insn_iter)) != NULL) {
+        PyObject *o = PyJitInsn_New(insn, self->function);
+        if (!o || PyList_Append(insns, o) < 0) {
+            Py_XDECREF(o);
+            Py_DECREF(insns);
+            return NULL;
+        }
+        Py_DECREF(o);
+    }
+
+    iter = PyObject_GetIter(insns);
+    Py_DECREF(insns);
+    return iter;
+}
+
+/* Regular methods */
+
+static PyObject *
+block_get_function(PyJitBlock *self)
+{
+    if (PyJitBlock_Verify(self) < 0)
+        return NULL;
+    Py_INCREF(self->function);
+    return self->function;
+}
+
+static PyObject *
+block_get_context(PyJitBlock *self)
+{
+    jit_context_t context;
+
+    if (PyJitBlock_Verify(self) < 0)
+        return NULL;
+    context = jit_block_get_context(self->block);
+    if (context)
+        return PyJitContext_New(context);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+block_get_label(PyJitBlock *self)
+{
+    jit_label_t label;
+
+    if (PyJitBlock_Verify(self) < 0)
+        return NULL;
+    label = jit_block_get_label(self->block);
+    if (label == jit_label_undefined)
+        Py_RETURN_NONE;
+    return PyJitLabel_New(label);
+}
+
+static PyObject *
+_block_iter(
+    PyObject *args, PyObject *kwargs,
+    jit_block_t (*iterfunc)(jit_function_t, jit_block_t))
+{
+    PyObject *func = NULL, *prev = NULL;
+    PyJitFunction *jit_function;
+    jit_block_t jit_prev = NULL, block;
+    static char *kwlist[] = { "func", "prev", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O:Block", kwlist,
+                                     &func, &prev))
+        return NULL;
+
+    jit_function = PyJitFunction_CastAndVerify(func);
+    if (!jit_function)
+        return NULL;
+
+    if (prev && prev != Py_None) {
+        PyJitBlock *jit_block = PyJitBlock_CastAndVerify(prev);
+        if (!jit_block)
+            return NULL;
+        jit_prev = jit_block->block;
+    }
+
+    block = iterfunc(jit_function->function, jit_prev);
+    if (block)
+        return PyJitBlock_New(block, func);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+block_next(void *null, PyObject *args, PyObject *kwargs)
+{
+    return _block_iter(args, kwargs, jit_block_next);
+}
+
+static PyObject *
+block_previous(void *null, PyObject *args, PyObject *kwargs)
+{
+    return _block_iter(args, kwargs, jit_block_previous);
+}
+
+static PyObject *
+block_is_reachable(PyJitBlock *self)
+{
+    if (PyJitBlock_Verify(self) < 0)
+        return NULL;
+    return PyBool_FromLong(jit_block_is_reachable(self->block));
+}
+
+static PyObject *
+block_ends_in_dead(PyJitBlock *self)
+{
+    if (PyJitBlock_Verify(self) < 0)
+        return NULL;
+    return PyBool_FromLong(jit_block_ends_in_dead(self->block));
+}
+
+static PyMethodDef block_methods[] = {
+    PYJIT_METHOD_NOARGS(block, get_function),
+    PYJIT_METHOD_NOARGS(block, get_context),
+    PYJIT_METHOD_NOARGS(block, get_label),
+    /* jit_block_get_next_label */
+    PYJIT_METHOD_EX("next_", block_next, METH_STATIC | METH_KEYWORDS),
+    PYJIT_STATIC_METHOD_KW(block, previous),
+    /* jit_block_from_label */
+    /* jit_block_set_meta */
+    /* jit_block_get_meta */
+    /* jit_block_free_meta */
+    PYJIT_METHOD_NOARGS(block, is_reachable),
+    PYJIT_METHOD_NOARGS(block, ends_in_dead),
+    /* jit_block_current_is_dead */
+    { NULL } /* Sentinel */
+};
+
+static PyTypeObject PyJitBlock_Type = {
+    PyObject_HEAD_INIT(NULL)
+    0,                                  /* ob_size */
+    "jit.Block",                        /* tp_name */
+    sizeof(PyJitBlock),                 /* tp_basicsize */
+    0,                                  /* tp_itemsize */
+    (destructor)block_dealloc,          /* tp_dealloc */
+    0,                                  /* tp_print */
+    0,                                  /* tp_getattr */
+    0,                                  /* tp_setattr */
+    0,                                  /* tp_compare */
+    (reprfunc)block_repr,               /* tp_repr */
+    0,                                  /* tp_as_number */
+    0,                                  /* tp_as_sequence */
+    0,                                  /* tp_as_mapping */
+    (hashfunc)block_hash,               /* tp_hash */
+    0,                                  /* tp_call */
+    0,                                  /* tp_str */
+    0,                                  /* tp_getattro */
+    0,                                  /* tp_setattro */
+    0,                                  /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                 /* tp_flags */
+    block_doc,                          /* tp_doc */
+    0,                                  /* tp_traverse */
+    0,                                  /* tp_clear */
+    0,                                  /* tp_richcompare */
+    offsetof(PyJitBlock, weakreflist),  /* tp_weaklistoffset */
+    (getiterfunc)block_iter,            /* tp_iter */
+    0,                                  /* tp_iternext */
+    block_methods                       /* tp_methods */
+};
+
+int
+pyjit_block_init(PyObject *module)
+{
+    if (PyType_Ready(&PyJitBlock_Type) < 0)
+        return -1;
+
+    /* Set up the block cache. */
+    block_cache = PyDict_New();
+    if (!block_cache)
+        return -1;
+
+    Py_INCREF(&PyJitBlock_Type);
+    PyModule_AddObject(module, "Block", (PyObject *)&PyJitBlock_Type);
+
+    return 0;
+}
+
+const PyTypeObject *
+pyjit_block_get_pytype(void)
+{
+    return &PyJitBlock_Type;
+}
+
+PyObject *
+PyJitBlock_New(jit_block_t block, PyObject *function)
+{
+    long numkey;
+    PyObject *object;
+
+    numkey = (long)block;
+    object = pyjit_weak_cache_getitem(block_cache, numkey);
+    if (!object) {
+        PyJitBlock *jit_block;
+
+        object = PyType_GenericNew(&PyJitBlock_Type, NULL, NULL);
+        if (!object)
+            return NULL;
+        jit_block = (PyJitBlock *)object;
+        jit_block->block = block;
+        Py_INCREF(function);
+        jit_block->function = function;
+
+        if (pyjit_weak_cache_setitem(block_cache, numkey, object) < 0) {
+            Py_DECREF(object);
+            return NULL;
+        }
+    }
+    return object;
+}
+
+int
+PyJitBlock_Check(PyObject *o)
+{
+    return PyObject_IsInstance(o, (PyObject *)&PyJitBlock_Type);
+}
+
+PyJitBlock *
+PyJitBlock_Cast(PyObject *o)
+{
+    int r = PyJitBlock_Check(o);
+    if (r == 1)
+        return (PyJitBlock *)o;
+    else if (r < 0 && PyErr_Occurred())
+        PyErr_Clear();
+    return NULL;
+}
+
+int
+PyJitBlock_Verify(PyJitBlock *o)
+{
+    if (!o->function || !o->block) {
+        PyErr_SetString(PyExc_ValueError, "block is not initialized");
+        return -1;
+    }
+    return 0;
+}
+
+PyJitBlock *
+PyJitBlock_CastAndVerify(PyObject *o)
+{
+    PyJitBlock *block = PyJitBlock_Cast(o);
+    if (!block) {
+        PyErr_Format(
+            PyExc_TypeError, "expected instance of %.100s, not %.100s",
+            pyjit_block_get_pytype()->tp_name, Py_TYPE(o)->tp_name);
+        return NULL;
+    }
+    if (PyJitBlock_Verify(block) < 0)
+        return NULL;
+    return block;
+}
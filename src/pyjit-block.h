@@ -0,0 +1,40 @@
+/* python-libjit, Copyright 2014 Niklas Koep
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PYJIT_BLOCK_H__
+#define __PYJIT_BLOCK_H__
+
+#include "pyjit-common.h"
+
+typedef struct {
+    PyObject_HEAD
+    /* Blocks are owned by the function they belong to and are discarded
+     * together with the function's builder once the function is compiled.
+     */
+    PyObject *function;
+    jit_block_t block;
+    PyObject *weakreflist;
+} PyJitBlock;
+
+int pyjit_block_init(PyObject *module);
+const PyTypeObject *pyjit_block_get_pytype(void);
+
+PyObject *PyJitBlock_New(jit_block_t block, PyObject *function);
+int PyJitBlock_Check(PyObject *o);
+PyJitBlock *PyJitBlock_Cast(PyObject *o);
+int PyJitBlock_Verify(PyJitBlock *o);
+PyJitBlock *PyJitBlock_CastAndVerify(PyObject *o);
+
+#endif /* __PYJIT_BLOCK_H__ */
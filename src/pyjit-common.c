@@ -16,6 +16,7 @@
 #include "pyjit-common.h"
 
 #include <ctype.h>
+#include <time.h>
 
 char *
 pyjit_strtoupper(char *s)
@@ -85,7 +86,6 @@ pyjit_weak_cache_getitem(PyObject *dict, long numkey)
     /* Drop the cache entry if the referent is no longer live. */
     if (o == Py_None) {
         pyjit_weak_cache_delitem(dict, numkey);
-        Py_DECREF(o);
         return NULL;
     }
     Py_INCREF(o);
@@ -110,3 +110,13 @@ pyjit_meta_free_func(void *data)
     Py_XDECREF((PyObject *)data);
 }
 
+/* Return the value of a monotonic clock in seconds. */
+double
+pyjit_monotonic_time(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+        return 0.0;
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
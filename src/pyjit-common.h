@@ -91,6 +91,7 @@ int pyjit_weak_cache_setitem(PyObject *dict, long numkey, PyObject *o);
 PyObject *pyjit_weak_cache_getitem(PyObject *dict, long numkey);
 int pyjit_weak_cache_delitem(PyObject *dict, long numkey);
 void pyjit_meta_free_func(void *data);
+double pyjit_monotonic_time(void);
 
 #endif /* __PYJIT_COMMON_H__ */
 
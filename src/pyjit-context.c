@@ -15,6 +15,9 @@
 
 #include "pyjit-context.h"
 
+#include "pyjit-except.h"
+#include "pyjit-function.h"
+
 PyDoc_STRVAR(context_doc, "Wrapper class for jit_context_t");
 
 static PyObject *context_cache = NULL;
@@ -59,6 +62,47 @@ context_init(PyJitContext *self, PyObject *args, PyObject *kwargs)
         context_cache, (long)self->context, (PyObject *)self);
 }
 
+/* Return a list of the wrappers of all functions in the context. */
+static PyObject *
+_context_functions(PyJitContext *self)
+{
+    PyObject *functions;
+    jit_function_t function = NULL;
+
+    functions = PyList_New(0);
+    if (!functions)
+        return NULL;
+
+    while ((function = jit_function_next(self->context, function)) != NULL) {
+        PyObject *o = pyjit_function_get_cached(function);
+        if (!o)
+            continue;
+        if (PyList_Append(functions, o) < 0) {
+            Py_DECREF(o);
+            Py_DECREF(functions);
+            return NULL;
+        }
+        Py_DECREF(o);
+    }
+    return functions;
+}
+
+static PyObject *
+context_iter(PyJitContext *self)
+{
+    PyObject *functions, *iter;
+
+    if (PyJitContext_Verify(self) < 0)
+        return NULL;
+
+    functions = _context_functions(self);
+    if (!functions)
+        return NULL;
+    iter = PyObject_GetIter(functions);
+    Py_DECREF(functions);
+    return iter;
+}
+
 /* Regular methods */
 
 static PyObject *context_enter(PyJitContext *self); /* Forward */
@@ -176,6 +220,73 @@ context_free_meta(PyJitContext *self, PyObject *args, PyObject *kwargs)
     Py_RETURN_NONE;
 }
 
+/* Compile all uncompiled functions of the context while holding the build
+ * lock once. The GIL is kept while compiling since freeing the builder runs
+ * the destructors of build-only meta, which may release Python objects.
+ * Returns a list of (function, seconds) tuples.
+ */
+static PyObject *
+context_compile_all(PyJitContext *self)
+{
+    PyObject *functions, *pending = NULL, *retval = NULL;
+    Py_ssize_t i, num_pending;
+
+    if (PyJitContext_Verify(self) < 0)
+        return NULL;
+
+    jit_context_build_start(self->context);
+
+    functions = _context_functions(self);
+    if (!functions)
+        goto out;
+
+    /* Sort out the functions which need compiling. */
+    pending = PyList_New(0);
+    if (!pending)
+        goto out;
+    for (i = 0; i < PyList_GET_SIZE(functions); i++) {
+        PyObject *o = PyList_GET_ITEM(functions, i);
+        jit_function_t function = ((PyJitFunction *)o)->function;
+        if (jit_function_is_compiled(function))
+            continue;
+        if (PyList_Append(pending, o) < 0)
+            goto out;
+    }
+
+    num_pending = PyList_GET_SIZE(pending);
+    retval = PyList_New(num_pending);
+    if (!retval)
+        goto out;
+
+    for (i = 0; i < num_pending; i++) {
+        PyObject *function = PyList_GET_ITEM(pending, i), *item;
+        double start, elapsed;
+        int r;
+
+        start = pyjit_monotonic_time();
+        r = jit_compile(((PyJitFunction *)function)->function);
+        elapsed = pyjit_monotonic_time() - start;
+        if (r != JIT_RESULT_OK) {
+            pyjit_raise_compile_error(r);
+            Py_CLEAR(retval);
+            goto out;
+        }
+
+        item = Py_BuildValue("(Od)", function, elapsed);
+        if (!item) {
+            Py_CLEAR(retval);
+            goto out;
+        }
+        PyList_SET_ITEM(retval, i, item);
+    }
+
+out:
+    jit_context_build_end(self->context);
+    Py_XDECREF(pending);
+    Py_XDECREF(functions);
+    return retval;
+}
+
 static PyObject *
 context_enter(PyJitContext *self)
 {
@@ -196,8 +307,7 @@ static PyMethodDef context_methods[] = {
     PYJIT_METHOD_KW(context, free_meta),
     PYJIT_METHOD_EX("__enter__", context_enter, METH_NOARGS),
     PYJIT_METHOD_EX("__exit__", context_build_end, METH_VARARGS),
-
-    /* TODO: Re-export jit_function_next, etc. here */
+    PYJIT_METHOD_NOARGS(context, compile_all),
     { NULL } /* Sentinel */
 };
 
@@ -229,10 +339,7 @@ static PyTypeObject PyJitContext_Type = {
     0,                                      /* tp_clear */
     0,                                      /* tp_richcompare */
     offsetof(PyJitContext, weakreflist),    /* tp_weaklistoffset */
-    /* TODO: Add support for iterating over a context to yield
-     *       jit.FunctionS.
-     */
-    0,                                      /* tp_iter */
+    (getiterfunc)context_iter,              /* tp_iter */
     0,                                      /* tp_iternext */
     context_methods,                        /* tp_methods */
     0,                                      /* tp_members */
@@ -0,0 +1,557 @@
+/* python-libjit, Copyright 2014 Niklas Koep
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pyjit-elf.h"
+
+#include "pyjit-context.h"
+#include "pyjit-function.h"
+
+PyDoc_STRVAR(readelf_doc, "Wrapper class for jit_readelf_t");
+PyDoc_STRVAR(writeelf_doc, "Wrapper class for jit_writeelf_t");
+
+static int
+_readelf_verify(PyJitReadElf *self)
+{
+    if (!self->readelf) {
+        PyErr_SetString(PyExc_ValueError, "readelf is not open");
+        return -1;
+    }
+    return 0;
+}
+
+static int
+_writeelf_verify(PyJitWriteElf *self)
+{
+    if (!self->writeelf) {
+        PyErr_SetString(PyExc_ValueError, "writeelf is not initialized");
+        return -1;
+    }
+    return 0;
+}
+
+/* Slot implementations */
+
+static void
+readelf_dealloc(PyJitReadElf *self)
+{
+    if (self->weakreflist)
+        PyObject_ClearWeakRefs((PyObject *)self);
+
+    /* Readers owned by a context are closed when the context is destroyed. */
+    if (self->readelf && !self->context)
+        jit_readelf_close(self->readelf);
+
+    Py_XDECREF(self->context);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+PYJIT_REPR_GENERIC(readelf_repr, PyJitReadElf, readelf)
+
+static int
+readelf_init(PyJitReadElf *self, PyObject *args, PyObject *kwargs)
+{
+    const char *filename = NULL;
+    int flags = 0, r;
+    jit_readelf_t readelf;
+    static char *kwlist[] = { "filename", "flags", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|i:ReadElf", kwlist,
+                                     &filename, &flags))
+        return -1;
+
+    if (self->readelf) {
+        PyErr_SetString(PyExc_ValueError, "readelf is already open");
+        return -1;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    r = jit_readelf_open(&readelf, filename, flags);
+    Py_END_ALLOW_THREADS
+
+    switch (r) {
+    case JIT_READELF_OK:
+        self->readelf = readelf;
+        return 0;
+    case JIT_READELF_CANNOT_OPEN:
+        PyErr_SetFromErrnoWithFilename(PyExc_IOError, (char *)filename);
+        break;
+    case JIT_READELF_NOT_ELF:
+        PyErr_Format(PyExc_ValueError, "'%.200s' is not an ELF binary",
+                     filename);
+        break;
+    case JIT_READELF_WRONG_ARCH:
+        PyErr_Format(PyExc_ValueError,
+                     "'%.200s' was built for a different architecture",
+                     filename);
+        break;
+    case JIT_READELF_BAD_FORMAT:
+        PyErr_Format(PyExc_ValueError, "'%.200s' is malformed", filename);
+        break;
+    case JIT_READELF_MEMORY:
+        PyErr_NoMemory();
+        break;
+    default:
+        PyErr_Format(PyExc_RuntimeError,
+                     "failed to open '%.200s' (error code %d)", filename, r);
+        break;
+    }
+    return -1;
+}
+
+/* Regular methods */
+
+static PyObject *
+readelf_close(PyJitReadElf *self)
+{
+    if (self->context) {
+        PyErr_SetString(PyExc_ValueError,
+                        "readelf is owned by a context and cannot be closed");
+        return NULL;
+    }
+    if (self->readelf) {
+        jit_readelf_close(self->readelf);
+        self->readelf = NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+readelf_get_name(PyJitReadElf *self)
+{
+    const char *name;
+
+    if (_readelf_verify(self) < 0)
+        return NULL;
+    name = jit_readelf_get_name(self->readelf);
+    if (name)
+        return PyString_FromString(name);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+readelf_get_symbol(PyJitReadElf *self, PyObject *args, PyObject *kwargs)
+{
+    const char *name = NULL;
+    void *symbol;
+    static char *kwlist[] = { "name", NULL };
+
+    if (_readelf_verify(self) < 0)
+        return NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s:ReadElf", kwlist,
+                                     &name))
+        return NULL;
+
+    symbol = jit_readelf_get_symbol(self->readelf, name);
+    if (symbol)
+        return PyLong_FromVoidPtr(symbol);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+readelf_get_section(PyJitReadElf *self, PyObject *args, PyObject *kwargs)
+{
+    const char *name = NULL;
+    void *section;
+    jit_nuint size = 0;
+    static char *kwlist[] = { "name", NULL };
+
+    if (_readelf_verify(self) < 0)
+        return NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s:ReadElf", kwlist,
+                                     &name))
+        return NULL;
+
+    section = jit_readelf_get_section(self->readelf, name, &size);
+    if (section)
+        return PyString_FromStringAndSize((const char *)section, size);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+readelf_num_needed(PyJitReadElf *self)
+{
+    if (_readelf_verify(self) < 0)
+        return NULL;
+    return PyLong_FromUnsignedLong(jit_readelf_num_needed(self->readelf));
+}
+
+static PyObject *
+readelf_get_needed(PyJitReadElf *self, PyObject *args, PyObject *kwargs)
+{
+    unsigned int index;
+    const char *needed;
+    static char *kwlist[] = { "index", NULL };
+
+    if (_readelf_verify(self) < 0)
+        return NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "I:ReadElf", kwlist,
+                                     &index))
+        return NULL;
+
+    needed = jit_readelf_get_needed(self->readelf, index);
+    if (needed)
+        return PyString_FromString(needed);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+readelf_add_to_context(PyJitReadElf *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *context = NULL;
+    PyJitContext *jit_context;
+    static char *kwlist[] = { "context", NULL };
+
+    if (_readelf_verify(self) < 0)
+        return NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O:ReadElf", kwlist,
+                                     &context))
+        return NULL;
+
+    jit_context = PyJitContext_CastAndVerify(context);
+    if (!jit_context)
+        return NULL;
+
+    if (self->context) {
+        PyErr_SetString(PyExc_ValueError,
+                        "readelf has already been added to a context");
+        return NULL;
+    }
+
+    jit_readelf_add_to_context(self->readelf, jit_context->context);
+    Py_INCREF(context);
+    self->context = context;
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+readelf_resolve_all(void *null, PyObject *args, PyObject *kwargs)
+{
+    PyObject *context = NULL, *print_failures = NULL;
+    PyJitContext *jit_context;
+    static char *kwlist[] = { "context", "print_failures", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O:ReadElf", kwlist,
+                                     &context, &print_failures))
+        return NULL;
+
+    jit_context = PyJitContext_CastAndVerify(context);
+    if (!jit_context)
+        return NULL;
+
+    return PyBool_FromLong(
+        jit_readelf_resolve_all(
+            jit_context->context,
+            print_failures ? PyObject_IsTrue(print_failures) : 0));
+}
+
+static PyObject *
+readelf_register_symbol(void *null, PyObject *args, PyObject *kwargs)
+{
+    PyObject *context = NULL, *value = NULL, *after = NULL;
+    const char *name = NULL;
+    void *jit_value;
+    PyJitContext *jit_context;
+    static char *kwlist[] = { "context", "name", "value", "after", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OsO|O:ReadElf", kwlist,
+                                     &context, &name, &value, &after))
+        return NULL;
+
+    jit_context = PyJitContext_CastAndVerify(context);
+    if (!jit_context)
+        return NULL;
+
+    jit_value = PyLong_AsVoidPtr(value);
+    if (!jit_value && PyErr_Occurred())
+        return NULL;
+
+    return PyBool_FromLong(
+        jit_readelf_register_symbol(jit_context->context, name, jit_value,
+                                    after ? PyObject_IsTrue(after) : 0));
+}
+
+static PyMethodDef readelf_methods[] = {
+    PYJIT_METHOD_NOARGS(readelf, close),
+    PYJIT_METHOD_NOARGS(readelf, get_name),
+    PYJIT_METHOD_KW(readelf, get_symbol),
+    PYJIT_METHOD_KW(readelf, get_section),
+    /* jit_readelf_get_section_by_type */
+    /* jit_readelf_map_vaddr */
+    PYJIT_METHOD_NOARGS(readelf, num_needed),
+    PYJIT_METHOD_KW(readelf, get_needed),
+    PYJIT_METHOD_KW(readelf, add_to_context),
+    PYJIT_STATIC_METHOD_KW(readelf, resolve_all),
+    PYJIT_STATIC_METHOD_KW(readelf, register_symbol),
+    { NULL } /* Sentinel */
+};
+
+static PyTypeObject PyJitReadElf_Type = {
+    PyObject_HEAD_INIT(NULL)
+    0,                                      /* ob_size */
+    "jit.ReadElf",                          /* tp_name */
+    sizeof(PyJitReadElf),                   /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor)readelf_dealloc,            /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    (reprfunc)readelf_repr,                 /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    readelf_doc,                            /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    offsetof(PyJitReadElf, weakreflist),    /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    readelf_methods,                        /* tp_methods */
+    0,                                      /* tp_members */
+    0,                                      /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    (initproc)readelf_init,                 /* tp_init */
+    0,                                      /* tp_alloc */
+    PyType_GenericNew                       /* tp_new */
+};
+
+/* Slot implementations */
+
+static void
+writeelf_dealloc(PyJitWriteElf *self)
+{
+    if (self->weakreflist)
+        PyObject_ClearWeakRefs((PyObject *)self);
+
+    if (self->writeelf)
+        jit_writeelf_destroy(self->writeelf);
+
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+PYJIT_REPR_GENERIC(writeelf_repr, PyJitWriteElf, writeelf)
+
+static int
+writeelf_init(PyJitWriteElf *self, PyObject *args, PyObject *kwargs)
+{
+    const char *library_name = NULL;
+    static char *kwlist[] = { "library_name", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s:WriteElf", kwlist,
+                                     &library_name))
+        return -1;
+
+    if (self->writeelf)
+        jit_writeelf_destroy(self->writeelf);
+    self->writeelf = jit_writeelf_create(library_name);
+    if (!self->writeelf) {
+        PyErr_SetString(PyExc_MemoryError,
+                        "memory allocation inside LibJIT failed");
+        return -1;
+    }
+    return 0;
+}
+
+/* Regular methods */
+
+static PyObject *
+writeelf_write(PyJitWriteElf *self, PyObject *args, PyObject *kwargs)
+{
+    const char *filename = NULL;
+    int r;
+    static char *kwlist[] = { "filename", NULL };
+
+    if (_writeelf_verify(self) < 0)
+        return NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s:WriteElf", kwlist,
+                                     &filename))
+        return NULL;
+
+    errno = 0;
+    Py_BEGIN_ALLOW_THREADS
+    r = jit_writeelf_write(self->writeelf, filename);
+    Py_END_ALLOW_THREADS
+
+    if (!r) {
+        /* LibJIT also fails without setting errno, e.g. when it runs out of
+         * memory while laying out the image.
+         */
+        if (errno == 0)
+            return PyErr_Format(PyExc_IOError,
+                                "cannot write ELF binary to '%.200s'", filename);
+        return PyErr_SetFromErrnoWithFilename(PyExc_IOError, (char *)filename);
+    }
+    Py_RETURN_NONE;
+}
+
+/* Note that jit_writeelf_add_function is a stub in LibJIT which does not emit
+ * the code of the function, so this is effectively a no-op.
+ */
+static PyObject *
+writeelf_add_function(PyJitWriteElf *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *func = NULL;
+    const char *name = NULL;
+    PyJitFunction *jit_function;
+    static char *kwlist[] = { "func", "name", NULL };
+
+    if (_writeelf_verify(self) < 0)
+        return NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Os:WriteElf", kwlist,
+                                     &func, &name))
+        return NULL;
+
+    jit_function = PyJitFunction_CastAndVerify(func);
+    if (!jit_function)
+        return NULL;
+
+    return PyBool_FromLong(
+        jit_writeelf_add_function(self->writeelf, jit_function->function,
+                                  name));
+}
+
+static PyObject *
+writeelf_add_needed(PyJitWriteElf *self, PyObject *args, PyObject *kwargs)
+{
+    const char *library_name = NULL;
+    static char *kwlist[] = { "library_name", NULL };
+
+    if (_writeelf_verify(self) < 0)
+        return NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s:WriteElf", kwlist,
+                                     &library_name))
+        return NULL;
+
+    return PyBool_FromLong(
+        jit_writeelf_add_needed(self->writeelf, library_name));
+}
+
+static PyObject *
+writeelf_write_section(PyJitWriteElf *self, PyObject *args, PyObject *kwargs)
+{
+    const char *name = NULL, *buf = NULL;
+    int type, len;
+    PyObject *discardable = NULL;
+    static char *kwlist[] = { "name", "type_", "buf", "discardable", NULL };
+
+    if (_writeelf_verify(self) < 0)
+        return NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sis#|O:WriteElf", kwlist,
+                                     &name, &type, &buf, &len, &discardable))
+        return NULL;
+
+    return PyBool_FromLong(
+        jit_writeelf_write_section(
+            self->writeelf, name, type, buf, (unsigned int)len,
+            discardable ? PyObject_IsTrue(discardable) : 0));
+}
+
+static PyMethodDef writeelf_methods[] = {
+    PYJIT_METHOD_KW(writeelf, write),
+    PYJIT_METHOD_KW(writeelf, add_function),
+    PYJIT_METHOD_KW(writeelf, add_needed),
+    PYJIT_METHOD_KW(writeelf, write_section),
+    { NULL } /* Sentinel */
+};
+
+static PyTypeObject PyJitWriteElf_Type = {
+    PyObject_HEAD_INIT(NULL)
+    0,                                      /* ob_size */
+    "jit.WriteElf",                         /* tp_name */
+    sizeof(PyJitWriteElf),                  /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor)writeelf_dealloc,           /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    (reprfunc)writeelf_repr,                /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    writeelf_doc,                           /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    offsetof(PyJitWriteElf, weakreflist),   /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    writeelf_methods,                       /* tp_methods */
+    0,                                      /* tp_members */
+    0,                                      /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    (initproc)writeelf_init,                /* tp_init */
+    0,                                      /* tp_alloc */
+    PyType_GenericNew                       /* tp_new */
+};
+
+int
+pyjit_elf_init(PyObject *module)
+{
+    if (PyType_Ready(&PyJitReadElf_Type) < 0)
+        return -1;
+    if (PyType_Ready(&PyJitWriteElf_Type) < 0)
+        return -1;
+
+    Py_INCREF(&PyJitReadElf_Type);
+    PyModule_AddObject(module, "ReadElf", (PyObject *)&PyJitReadElf_Type);
+    Py_INCREF(&PyJitWriteElf_Type);
+    PyModule_AddObject(module, "WriteElf", (PyObject *)&PyJitWriteElf_Type);
+
+    return 0;
+}
+
+const PyTypeObject *
+pyjit_readelf_get_pytype(void)
+{
+    return &PyJitReadElf_Type;
+}
+
+const PyTypeObject *
+pyjit_writeelf_get_pytype(void)
+{
+    return &PyJitWriteElf_Type;
+}
@@ -0,0 +1,43 @@
+/* python-libjit, Copyright 2014 Niklas Koep
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PYJIT_ELF_H__
+#define __PYJIT_ELF_H__
+
+#include "pyjit-common.h"
+
+typedef struct {
+    PyObject_HEAD
+    /* Once a reader has been handed to a context via
+     * jit_readelf_add_to_context, the context owns the reader and will close
+     * it on destruction. We keep a reference to the context wrapper so the
+     * mapped image outlives any functions referring to it.
+     */
+    PyObject *context;
+    jit_readelf_t readelf;
+    PyObject *weakreflist;
+} PyJitReadElf;
+
+typedef struct {
+    PyObject_HEAD
+    jit_writeelf_t writeelf;
+    PyObject *weakreflist;
+} PyJitWriteElf;
+
+int pyjit_elf_init(PyObject *module);
+const PyTypeObject *pyjit_readelf_get_pytype(void);
+const PyTypeObject *pyjit_writeelf_get_pytype(void);
+
+#endif /* __PYJIT_ELF_H__ */
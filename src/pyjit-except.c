@@ -0,0 +1,202 @@
+/* python-libjit, Copyright 2014 Niklas Koep
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pyjit-except.h"
+
+PyDoc_STRVAR(compile_error_doc,
+"Raised when LibJIT fails to compile a function. The `result' attribute holds\n"
+"the JIT_RESULT_* code reported by jit_compile.");
+
+PyDoc_STRVAR(thrown_error_doc,
+"Raised when a JIT'ed function throws an exception which it does not catch\n"
+"itself. For objects thrown with jit.Insn.throw, the `value' attribute holds\n"
+"the address of the thrown object and `result' is None. For LibJIT's builtin\n"
+"exceptions without a Python counterpart, `value' is None and `result' holds\n"
+"the JIT_RESULT_* code.");
+
+static PyObject *compile_error = NULL;
+static PyObject *thrown_error = NULL;
+
+/* Builtin exceptions are thrown as pointers into this table, which allows
+ * telling them apart from objects thrown by JIT'ed code.
+ */
+static const int builtin_exceptions[] = {
+    JIT_RESULT_OVERFLOW,
+    JIT_RESULT_ARITHMETIC,
+    JIT_RESULT_DIVISION_BY_ZERO,
+    JIT_RESULT_COMPILE_ERROR,
+    JIT_RESULT_OUT_OF_MEMORY,
+    JIT_RESULT_NULL_REFERENCE,
+    JIT_RESULT_NULL_FUNCTION,
+    JIT_RESULT_CALLED_NESTED,
+    JIT_RESULT_OUT_OF_BOUNDS,
+    JIT_RESULT_UNDEFINED_LABEL,
+    JIT_RESULT_MEMORY_FULL
+};
+
+#define NUM_BUILTIN_EXCEPTIONS \
+    (sizeof(builtin_exceptions) / sizeof(builtin_exceptions[0]))
+
+const char *
+pyjit_result_to_string(int result)
+{
+    switch (result) {
+    case JIT_RESULT_OK:
+        return "success";
+    case JIT_RESULT_OVERFLOW:
+        return "arithmetic overflow";
+    case JIT_RESULT_ARITHMETIC:
+        return "arithmetic exception";
+    case JIT_RESULT_DIVISION_BY_ZERO:
+        return "division by zero";
+    case JIT_RESULT_COMPILE_ERROR:
+        return "error during compilation";
+    case JIT_RESULT_OUT_OF_MEMORY:
+        return "out of memory";
+    case JIT_RESULT_NULL_REFERENCE:
+        return "null reference";
+    case JIT_RESULT_NULL_FUNCTION:
+        return "null function";
+    case JIT_RESULT_CALLED_NESTED:
+        return "nested function called from non-nested context";
+    case JIT_RESULT_OUT_OF_BOUNDS:
+        return "array index out of bounds";
+    case JIT_RESULT_UNDEFINED_LABEL:
+        return "undefined label";
+    case JIT_RESULT_MEMORY_FULL:
+        return "code cache is full";
+    }
+    return "unknown error";
+}
+
+/* Raise an instance of `type' with the attribute `name' set to `attr'. The
+ * reference to `attr' is stolen.
+ */
+static PyObject *
+_raise_with_attribute(PyObject *type, const char *message, const char *name,
+                      PyObject *attr)
+{
+    PyObject *exc;
+
+    if (!attr)
+        return NULL;
+    exc = PyObject_CallFunction(type, "s", message);
+    if (!exc || PyObject_SetAttrString(exc, name, attr) < 0) {
+        Py_XDECREF(exc);
+        Py_DECREF(attr);
+        return NULL;
+    }
+    Py_DECREF(attr);
+    PyErr_SetObject(type, exc);
+    Py_DECREF(exc);
+    return NULL;
+}
+
+PyObject *
+pyjit_raise_compile_error(int result)
+{
+    return _raise_with_attribute(compile_error,
+                                 pyjit_result_to_string(result), "result",
+                                 PyInt_FromLong(result));
+}
+
+void *
+pyjit_exception_handler(int exception_type)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_BUILTIN_EXCEPTIONS; i++) {
+        if (builtin_exceptions[i] == exception_type)
+            return (void *)&builtin_exceptions[i];
+    }
+    /* Unknown codes are reported as arithmetic exceptions. */
+    return (void *)&builtin_exceptions[1];
+}
+
+static PyObject *
+_raise_builtin_exception(int result)
+{
+    PyObject *type;
+
+    switch (result) {
+    case JIT_RESULT_OVERFLOW:
+        type = PyExc_OverflowError;
+        break;
+    case JIT_RESULT_ARITHMETIC:
+        type = PyExc_ArithmeticError;
+        break;
+    case JIT_RESULT_DIVISION_BY_ZERO:
+        type = PyExc_ZeroDivisionError;
+        break;
+    case JIT_RESULT_OUT_OF_MEMORY:
+        type = PyExc_MemoryError;
+        break;
+    case JIT_RESULT_OUT_OF_BOUNDS:
+        type = PyExc_IndexError;
+        break;
+    default:
+        return _raise_with_attribute(thrown_error,
+                                     pyjit_result_to_string(result),
+                                     "result", PyInt_FromLong(result));
+    }
+    PyErr_SetString(type, pyjit_result_to_string(result));
+    return NULL;
+}
+
+PyObject *
+pyjit_raise_thrown_exception(void)
+{
+    void *object = jit_exception_get_last_and_clear();
+    const int *first = builtin_exceptions;
+    const int *last = builtin_exceptions + NUM_BUILTIN_EXCEPTIONS - 1;
+
+    if (!object) {
+        PyErr_SetString(PyExc_RuntimeError, "failed to apply function");
+        return NULL;
+    }
+    if ((const int *)object >= first && (const int *)object <= last)
+        return _raise_builtin_exception(*(const int *)object);
+    return _raise_with_attribute(thrown_error, "uncaught exception in JIT'ed "
+                                 "function", "value",
+                                 PyLong_FromVoidPtr(object));
+}
+
+int
+pyjit_except_init(PyObject *module)
+{
+    compile_error = PyErr_NewExceptionWithDoc(
+        "jit.CompileError", compile_error_doc, PyExc_RuntimeError, NULL);
+    if (!compile_error)
+        return -1;
+
+    Py_INCREF(compile_error);
+    PyModule_AddObject(module, "CompileError", compile_error);
+
+    thrown_error = PyErr_NewExceptionWithDoc(
+        "jit.ThrownError", thrown_error_doc, PyExc_RuntimeError, NULL);
+    if (!thrown_error)
+        return -1;
+    /* Instances only set the attribute which applies to them. */
+    if (PyObject_SetAttrString(thrown_error, "value", Py_None) < 0 ||
+        PyObject_SetAttrString(thrown_error, "result", Py_None) < 0)
+        return -1;
+
+    Py_INCREF(thrown_error);
+    PyModule_AddObject(module, "ThrownError", thrown_error);
+
+    jit_exception_set_handler(pyjit_exception_handler);
+
+    return 0;
+}
@@ -0,0 +1,27 @@
+/* python-libjit, Copyright 2014 Niklas Koep
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PYJIT_EXCEPT_H__
+#define __PYJIT_EXCEPT_H__
+
+#include "pyjit-common.h"
+
+int pyjit_except_init(PyObject *module);
+const char *pyjit_result_to_string(int result);
+PyObject *pyjit_raise_compile_error(int result);
+void *pyjit_exception_handler(int exception_type);
+PyObject *pyjit_raise_thrown_exception(void);
+
+#endif /* __PYJIT_EXCEPT_H__ */
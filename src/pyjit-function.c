@@ -16,11 +16,17 @@
 #include "pyjit-function.h"
 
 #include "pyjit-context.h"
+#include "pyjit-except.h"
 #include "pyjit-insn.h"
 #include "pyjit-marshal.h"
 #include "pyjit-type.h"
 #include "pyjit-value.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 PyDoc_STRVAR(function_doc, "Wrapper class for jit_function_t");
 
 static PyObject *function_cache = NULL;
@@ -156,6 +162,27 @@ function_init(PyJitFunction *self, PyObject *args, PyObject *kwargs)
 
 /* Regular methods */
 
+/* Discard a function which has not been compiled, removing it from its
+ * context. The wrapper is unusable afterwards.
+ */
+static PyObject *
+function_abandon(PyJitFunction *self)
+{
+    if (PyJitFunction_Verify(self) < 0)
+        return NULL;
+
+    if (jit_function_is_compiled(self->function)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "cannot abandon a compiled function");
+        return NULL;
+    }
+    if (pyjit_weak_cache_delitem(function_cache, (long)self->function) < 0)
+        return NULL;
+    jit_function_abandon(self->function);
+    self->function = NULL;
+    Py_RETURN_NONE;
+}
+
 static PyObject *
 function_get_context(PyJitFunction *self)
 {
@@ -325,6 +352,49 @@ function_to_closure(PyJitFunction *self)
     Py_RETURN_NONE;
 }
 
+static PyObject *
+function_to_vtable_pointer(PyJitFunction *self)
+{
+    void *pointer;
+
+    if (PyJitFunction_Verify(self) < 0)
+        return NULL;
+    pointer = jit_function_to_vtable_pointer(self->function);
+    if (pointer)
+        return PyLong_FromVoidPtr(pointer);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+function_from_vtable_pointer(void *null, PyObject *args, PyObject *kwargs)
+{
+    PyObject *context = NULL, *vtable_pointer = NULL;
+    PyJitContext *jit_context;
+    void *pointer;
+    jit_function_t function;
+    static char *kwlist[] = { "context", "vtable_pointer", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO:Function", kwlist,
+                                     &context, &vtable_pointer))
+        return NULL;
+
+    jit_context = PyJitContext_CastAndVerify(context);
+    if (!jit_context)
+        return NULL;
+
+    pointer = PyLong_AsVoidPtr(vtable_pointer);
+    if (!pointer && PyErr_Occurred())
+        return NULL;
+
+    function = jit_function_from_vtable_pointer(jit_context->context, pointer);
+    if (function) {
+        PyObject *o = pyjit_function_get_cached(function);
+        if (o)
+            return o;
+    }
+    Py_RETURN_NONE;
+}
+
 /* ... */
 
 /* FIXME: We need to track the construction of values, instructions, etc.
@@ -338,25 +408,60 @@ function_to_closure(PyJitFunction *self)
 static PyObject *
 function_compile(PyJitFunction *self)
 {
+    int r;
+
     if (PyJitFunction_Verify(self) < 0)
         return NULL;
 
-    if (!jit_function_compile(self->function)) {
-        PyErr_SetString(PyExc_RuntimeError, "failed to compile function");
+    /* LibJIT reports functions which don't fit into a single code cache region
+     * as JIT_RESULT_MEMORY_FULL. The region size is bounded by
+     * OPTION_CACHE_MAX_PAGE_FACTOR, which is only read when the code cache of
+     * the context is created, i.e. before its first function is compiled.
+     */
+    r = jit_compile(self->function);
+    if (r != JIT_RESULT_OK)
+        return pyjit_raise_compile_error(r);
+    Py_RETURN_NONE;
+}
+
+/* Install a precompiled entry point, e.g. one obtained from jit.ReadElf, so
+ * that the function can be applied without building or compiling it first.
+ */
+static PyObject *
+function_setup_entry(PyJitFunction *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *entry_point = NULL;
+    void *entry;
+    static char *kwlist[] = { "entry_point", NULL };
+
+    if (PyJitFunction_Verify(self) < 0)
+        return NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O:Function", kwlist,
+                                     &entry_point))
+        return NULL;
+
+    entry = PyLong_AsVoidPtr(entry_point);
+    if (!entry) {
+        if (!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "entry_point must not be NULL");
         return NULL;
     }
+
+    jit_function_setup_entry(self->function, entry);
     Py_RETURN_NONE;
 }
 
 static PyObject *
 function_apply(PyJitFunction *self, PyObject *args, PyObject *kwargs)
 {
-    PyObject *args_ = NULL, *retval = NULL;
-    int r;
+    PyObject *args_ = NULL, *out = NULL, *release_gil = NULL, *retval = NULL;
+    Py_buffer out_view;
+    int r, kind, nogil = 0, ok;
     unsigned int num_params, num_params_given;
     void **jit_args = NULL, *return_area = NULL;
     jit_type_t signature, return_type;
-    static char *kwlist[] = { "args", NULL };
+    static char *kwlist[] = { "args", "out", "release_gil", NULL };
 
     if (PyJitFunction_Verify(self) < 0)
         return NULL;
@@ -366,9 +471,14 @@ function_apply(PyJitFunction *self, PyObject *args, PyObject *kwargs)
         return NULL;
     }
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O:Function", kwlist,
-                                     &args_))
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OO:Function", kwlist,
+                                     &args_, &out, &release_gil))
         return NULL;
+    if (release_gil) {
+        nogil = PyObject_IsTrue(release_gil);
+        if (nogil < 0)
+            return NULL;
+    }
 
     r = PySequence_Check(args_);
     if (r < 0) {
@@ -389,27 +499,84 @@ function_apply(PyJitFunction *self, PyObject *args, PyObject *kwargs)
         return NULL;
     }
 
+    /* Struct and union results may be written directly into a buffer
+     * supplied by the caller, in which case `out' is returned.
+     */
+    return_type = jit_type_get_return(signature);
+    if (out && out != Py_None) {
+        kind = jit_type_get_kind(jit_type_remove_tags(return_type));
+        if (kind != JIT_TYPE_STRUCT && kind != JIT_TYPE_UNION) {
+            PyErr_SetString(PyExc_TypeError,
+                            "out is only supported for struct and union "
+                            "return types");
+            return NULL;
+        }
+        if (PyObject_GetBuffer(out, &out_view, PyBUF_WRITABLE) < 0)
+            return NULL;
+        if (out_view.len < (Py_ssize_t)jit_type_get_size(return_type)) {
+            PyErr_SetString(PyExc_ValueError,
+                            "out is too small for the return type");
+            PyBuffer_Release(&out_view);
+            return NULL;
+        }
+    }
+    else
+        out = NULL;
+
     /* Marshal Python arguments to appropriate C types. */
-    if (pyjit_marshal_arg_list_from_py(args_, signature, &jit_args) < 0)
+    if (pyjit_marshal_arg_list_from_py(args_, signature, &jit_args) < 0) {
+        if (out)
+            PyBuffer_Release(&out_view);
         return NULL;
+    }
 
     /* Allocate space for the return value. */
-    return_type = jit_type_get_return(signature);
-    return_area = PyMem_Malloc(jit_type_get_size(return_type));
+    if (out)
+        return_area = out_view.buf;
+    else {
+        return_area = PyMem_Malloc(jit_type_get_size(return_type));
+        if (!return_area) {
+            pyjit_marshal_free_arg_list(jit_args, signature);
+            return PyErr_NoMemory();
+        }
+    }
 
-    if (!jit_function_apply(self->function, jit_args, return_area)) {
-        PyErr_SetString(PyExc_RuntimeError, "failed to apply function");
+    /* LibJIT keeps the exception handler per thread, so install it for the
+     * calling thread before running any JIT'ed code. Without a handler,
+     * builtin exceptions such as division by zero terminate the process.
+     */
+    jit_exception_set_handler(pyjit_exception_handler);
+    if (nogil) {
+        /* Functions which don't call back into Python may run without the
+         * GIL. The marshaled arguments stay valid until the call returns.
+         */
+        Py_BEGIN_ALLOW_THREADS
+        ok = jit_function_apply(self->function, jit_args, return_area);
+        Py_END_ALLOW_THREADS
+    }
+    else
+        ok = jit_function_apply(self->function, jit_args, return_area);
+    if (!ok) {
+        pyjit_raise_thrown_exception();
     }
     else {
         /* This may raise an exception, but at this point the failure and
          * success paths are identical anyway so we don't have to explicitly
          * check `retval'.
          */
-        retval = pyjit_marshal_arg_to_py(return_type, return_area);
+        if (out) {
+            Py_INCREF(out);
+            retval = out;
+        }
+        else
+            retval = pyjit_marshal_arg_to_py(return_type, return_area);
     }
 
-    pyjit_marshal_free_arg_list(jit_args, num_params);
-    PyMem_Free(return_area);
+    pyjit_marshal_free_arg_list(jit_args, signature);
+    if (out)
+        PyBuffer_Release(&out_view);
+    else
+        PyMem_Free(return_area);
 
     return retval;
 }
@@ -548,6 +715,47 @@ DEFINE_UNARY_METHOD(sign)
 #undef DEFINE_UNARY_METHOD
 #undef DEFINE_BINARY_METHOD
 
+/* Forward a call to a static method of jit.Insn with `self' prepended to the
+ * positional arguments.
+ */
+static PyObject *
+_function_insn_forward(
+    PyJitFunction *self, PyObject *args, PyObject *kwargs,
+    PyObject *(*insnfunc)(void *, PyObject *, PyObject *))
+{
+    PyObject *prefix, *args_, *retval;
+
+    prefix = PyTuple_Pack(1, (PyObject *)self);
+    if (!prefix)
+        return NULL;
+    args_ = PySequence_Concat(prefix, args);
+    Py_DECREF(prefix);
+    if (!args_)
+        return NULL;
+    retval = insnfunc(NULL, args_, kwargs);
+    Py_DECREF(args_);
+    return retval;
+}
+
+#define DEFINE_FORWARD_METHOD(name)                                         \
+static PyObject *                                                           \
+function_insn_##name(PyJitFunction *self, PyObject *args, PyObject *kwargs) \
+{                                                                           \
+    return _function_insn_forward(self, args, kwargs, pyjit_insn_##name);   \
+}
+
+DEFINE_FORWARD_METHOD(call)
+DEFINE_FORWARD_METHOD(call_indirect)
+DEFINE_FORWARD_METHOD(call_indirect_vtable)
+DEFINE_FORWARD_METHOD(call_native)
+DEFINE_FORWARD_METHOD(memcpy)
+DEFINE_FORWARD_METHOD(memmove)
+DEFINE_FORWARD_METHOD(memset)
+DEFINE_FORWARD_METHOD(alloca)
+DEFINE_FORWARD_METHOD(jump_table)
+
+#undef DEFINE_FORWARD_METHOD
+
 static PyObject *
 function_insn_return(PyJitFunction *self, PyObject *args, PyObject *kwargs)
 {
@@ -575,7 +783,589 @@ function_insn_return(PyJitFunction *self, PyObject *args, PyObject *kwargs)
     return PyBool_FromLong(jit_insn_return(self->function, jit_value));
 }
 
+/* Structured loops
+ *
+ * jit.Function.loop(start, stop, step=1, unroll=1) returns a decorator which
+ * emits a counted loop around the decorated body. The body is called with the
+ * induction variable and may emit arbitrary instructions, but must not assign
+ * to the induction variable itself. With unroll=k the body is emitted k times
+ * per iteration of the main loop, followed by a remainder loop handling the
+ * trailing iterations one at a time. Both loops are rotated so that the
+ * condition is only tested once per iteration at the bottom.
+ */
+static int
+_function_loop_check(void *o)
+{
+    if (!o) {
+        PyErr_SetString(PyExc_MemoryError,
+                        "memory allocation inside LibJIT failed");
+        return -1;
+    }
+    return 0;
+}
+
+static jit_value_t
+_function_loop_bound(PyJitFunction *self, PyObject *o, const char *arg_name)
+{
+    PyJitValue *jit_value;
+    jit_value_t value;
+
+    if (PyInt_Check(o) || PyLong_Check(o)) {
+        jit_nint constant = PyLong_AsLong(o);
+        if (constant == -1 && PyErr_Occurred())
+            return NULL;
+        value = jit_value_create_nint_constant(self->function, jit_type_nint,
+                                               constant);
+    }
+    else {
+        jit_value = PyJitValue_Cast(o);
+        if (!jit_value) {
+            pyjit_raise_type_error(arg_name, pyjit_value_get_pytype(), o);
+            return NULL;
+        }
+        value = jit_insn_convert(self->function, jit_value->value,
+                                 jit_type_nint, 0);
+    }
+    if (_function_loop_check(value) < 0)
+        return NULL;
+    return value;
+}
+
+/* Emit `body' for as long as `counter' compares less than (or greater than for
+ * negative steps) `limit', advancing the counter by `step' after each copy.
+ */
+static int
+_function_loop_emit(PyJitFunction *self, PyObject *body, PyObject *py_counter,
+                    jit_value_t counter, jit_value_t limit, jit_nint step,
+                    int copies)
+{
+    jit_function_t function = self->function;
+    jit_label_t top = jit_label_undefined, test = jit_label_undefined;
+    jit_value_t step_value, next, cond;
+    PyObject *result;
+    int i;
+
+    step_value = jit_value_create_nint_constant(function, jit_type_nint, step);
+    if (_function_loop_check(step_value) < 0)
+        return -1;
+
+    if (!jit_insn_branch(function, &test) || !jit_insn_label(function, &top))
+        return _function_loop_check(NULL);
+    for (i = 0; i < copies; i++) {
+        result = PyObject_CallFunctionObjArgs(body, py_counter, NULL);
+        if (!result)
+            return -1;
+        Py_DECREF(result);
+        next = jit_insn_add(function, counter, step_value);
+        if (_function_loop_check(next) < 0)
+            return -1;
+        if (!jit_insn_store(function, counter, next))
+            return _function_loop_check(NULL);
+    }
+    if (!jit_insn_label(function, &test))
+        return _function_loop_check(NULL);
+    if (step > 0)
+        cond = jit_insn_lt(function, counter, limit);
+    else
+        cond = jit_insn_gt(function, counter, limit);
+    if (_function_loop_check(cond) < 0)
+        return -1;
+    if (!jit_insn_branch_if(function, cond, &top))
+        return _function_loop_check(NULL);
+    return 0;
+}
+
+static PyObject *
+_function_loop_apply(PyObject *state, PyObject *body)
+{
+    PyJitFunction *self;
+    PyObject *start, *stop, *py_counter;
+    jit_value_t start_value, stop_value, counter, limit;
+    jit_nint step;
+    int unroll;
+
+    self = (PyJitFunction *)PyTuple_GET_ITEM(state, 0);
+    start = PyTuple_GET_ITEM(state, 1);
+    stop = PyTuple_GET_ITEM(state, 2);
+    step = PyInt_AsLong(PyTuple_GET_ITEM(state, 3));
+    unroll = (int)PyInt_AsLong(PyTuple_GET_ITEM(state, 4));
+
+    if (PyJitFunction_Verify(self) < 0)
+        return NULL;
+
+    if (!PyCallable_Check(body)) {
+        PyErr_Format(PyExc_TypeError, "loop body must be callable, not %.100s",
+                     Py_TYPE(body)->tp_name);
+        return NULL;
+    }
+
+    start_value = _function_loop_bound(self, start, "start");
+    if (!start_value)
+        return NULL;
+    stop_value = _function_loop_bound(self, stop, "stop");
+    if (!stop_value)
+        return NULL;
+
+    counter = jit_value_create(self->function, jit_type_nint);
+    if (_function_loop_check(counter) < 0)
+        return NULL;
+    if (!jit_insn_store(self->function, counter, start_value)) {
+        _function_loop_check(NULL);
+        return NULL;
+    }
+
+    py_counter = PyJitValue_New(counter, (PyObject *)self);
+    if (!py_counter)
+        return NULL;
+
+    if (unroll > 1) {
+        /* The main loop may run while the last of its copies still lies
+         * within bounds, i.e. while counter < stop - (unroll - 1) * step.
+         */
+        jit_value_t span = jit_value_create_nint_constant(
+            self->function, jit_type_nint, (jit_nint)(unroll - 1) * step);
+        if (_function_loop_check(span) < 0)
+            goto error;
+        limit = jit_insn_sub(self->function, stop_value, span);
+        if (_function_loop_check(limit) < 0)
+            goto error;
+        if (_function_loop_emit(self, body, py_counter, counter, limit, step,
+                                unroll) < 0)
+            goto error;
+    }
+    if (_function_loop_emit(self, body, py_counter, counter, stop_value, step,
+                            1) < 0)
+        goto error;
+
+    Py_DECREF(py_counter);
+    Py_INCREF(body);
+    return body;
+
+error:
+    Py_DECREF(py_counter);
+    return NULL;
+}
+
+static PyMethodDef function_loop_def = {
+    "loop", (PyCFunction)_function_loop_apply, METH_O, NULL
+};
+
+static PyObject *
+function_loop(PyJitFunction *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *start = NULL, *stop = NULL, *state, *retval;
+    long step = 1;
+    int unroll = 1;
+    static char *kwlist[] = { "start", "stop", "step", "unroll", NULL };
+
+    if (PyJitFunction_Verify(self) < 0)
+        return NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|li:Function", kwlist,
+                                     &start, &stop, &step, &unroll))
+        return NULL;
+
+    if (step == 0) {
+        PyErr_SetString(PyExc_ValueError, "step must not be zero");
+        return NULL;
+    }
+    if (unroll < 1) {
+        PyErr_SetString(PyExc_ValueError, "unroll must be at least 1");
+        return NULL;
+    }
+
+    state = Py_BuildValue("(OOOli)", (PyObject *)self, start, stop, step,
+                          unroll);
+    if (!state)
+        return NULL;
+    retval = PyCFunction_NewEx(&function_loop_def, state, NULL);
+    Py_DECREF(state);
+    return retval;
+}
+
+/* Branch-free selection
+ *
+ * jit.Function.select(cond, a, b) evaluates to `a' if `cond' is true and to
+ * `b' otherwise. Integers and pointers are blended with a mask derived from
+ * the condition, i.e. b ^ ((a ^ b) & -(cond != 0)). LibJIT has no
+ * instruction which reinterprets the bits of a float in a register, and doing
+ * so through memory costs a store and a load per operand, so floats and
+ * aggregates fall back to a conditional branch.
+ */
+static jit_value_t
+_function_select_operand(PyJitFunction *self, PyObject *o, jit_type_t type,
+                         const char *arg_name)
+{
+    PyJitValue *jit_value;
+    jit_value_t value;
+
+    jit_value = PyJitValue_Cast(o);
+    if (jit_value)
+        value = jit_value->value;
+    else if (PyInt_Check(o) || PyLong_Check(o)) {
+        jit_nint constant = PyLong_AsLong(o);
+        if (constant == -1 && PyErr_Occurred())
+            return NULL;
+        value = jit_value_create_nint_constant(self->function, jit_type_nint,
+                                               constant);
+    }
+    else if (PyFloat_Check(o)) {
+        value = jit_value_create_float64_constant(
+            self->function, jit_type_float64, PyFloat_AS_DOUBLE(o));
+    }
+    else {
+        pyjit_raise_type_error(arg_name, pyjit_value_get_pytype(), o);
+        return NULL;
+    }
+    if (value)
+        value = jit_insn_convert(self->function, value, type, 0);
+    if (!value) {
+        PyErr_SetString(PyExc_MemoryError,
+                        "memory allocation inside LibJIT failed");
+    }
+    return value;
+}
+
+/* Select `a' or `b' of the integer type `type' without branching by blending
+ * them with the mask 0 - bool(cond), i.e. b ^ ((a ^ b) & mask). Only integer
+ * kinds take this path; floats are selected with a branch.
+ */
+static jit_value_t
+_function_select_masked(jit_function_t function, jit_value_t cond,
+                        jit_value_t a, jit_value_t b, jit_type_t type)
+{
+    jit_value_t zero, mask, bits;
+
+    zero = jit_value_create_nint_constant(function, type, 0);
+    mask = jit_insn_to_bool(function, cond);
+    if (!zero || !mask)
+        return NULL;
+    mask = jit_insn_convert(function, mask, type, 0);
+    if (!mask)
+        return NULL;
+    mask = jit_insn_sub(function, zero, mask);
+    if (!mask)
+        return NULL;
+    bits = jit_insn_xor(function, a, b);
+    if (!bits)
+        return NULL;
+    bits = jit_insn_and(function, bits, mask);
+    if (!bits)
+        return NULL;
+    return jit_insn_xor(function, b, bits);
+}
+
+static jit_value_t
+_function_select_branch(jit_function_t function, jit_value_t cond,
+                        jit_value_t a, jit_value_t b, jit_type_t type)
+{
+    jit_label_t other = jit_label_undefined, end = jit_label_undefined;
+    jit_value_t result;
+
+    result = jit_value_create(function, type);
+    if (!result ||
+        !jit_insn_branch_if_not(function, cond, &other) ||
+        !jit_insn_store(function, result, a) ||
+        !jit_insn_branch(function, &end) ||
+        !jit_insn_label(function, &other) ||
+        !jit_insn_store(function, result, b) ||
+        !jit_insn_label(function, &end))
+        return NULL;
+    return result;
+}
+
+static PyObject *
+function_select(PyJitFunction *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *cond = NULL, *a = NULL, *b = NULL;
+    PyJitValue *jit_cond, *typed;
+    jit_value_t value_a, value_b, result;
+    jit_type_t type, bits_type;
+    static char *kwlist[] = { "cond", "a", "b", NULL };
+
+    if (PyJitFunction_Verify(self) < 0)
+        return NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO:Function", kwlist,
+                                     &cond, &a, &b))
+        return NULL;
+
+    jit_cond = PyJitValue_Cast(cond);
+    if (!jit_cond)
+        return pyjit_raise_type_error("cond", pyjit_value_get_pytype(), cond);
+
+    /* The result has the type of whichever operand is a jit.Value. */
+    typed = PyJitValue_Cast(a);
+    if (!typed)
+        typed = PyJitValue_Cast(b);
+    if (!typed) {
+        PyErr_SetString(PyExc_TypeError,
+                        "at least one of a and b must be a jit.Value");
+        return NULL;
+    }
+    type = jit_value_get_type(typed->value);
+
+    value_a = _function_select_operand(self, a, type, "a");
+    if (!value_a)
+        return NULL;
+    value_b = _function_select_operand(self, b, type, "b");
+    if (!value_b)
+        return NULL;
+
+    bits_type = jit_type_promote_int(jit_type_normalize(type));
+    switch (jit_type_get_kind(bits_type)) {
+    case JIT_TYPE_INT:
+    case JIT_TYPE_UINT:
+    case JIT_TYPE_LONG:
+    case JIT_TYPE_ULONG:
+        value_a = jit_insn_convert(self->function, value_a, bits_type, 0);
+        value_b = jit_insn_convert(self->function, value_b, bits_type, 0);
+        result = NULL;
+        if (value_a && value_b) {
+            result = _function_select_masked(self->function, jit_cond->value,
+                                             value_a, value_b, bits_type);
+        }
+        if (result)
+            result = jit_insn_convert(self->function, result, type, 0);
+        break;
+
+    default:
+        result = _function_select_branch(self->function, jit_cond->value,
+                                         value_a, value_b, type);
+        break;
+    }
+
+    if (!result) {
+        PyErr_SetString(PyExc_MemoryError,
+                        "memory allocation inside LibJIT failed");
+        return NULL;
+    }
+    return PyJitValue_New(result, (PyObject *)self);
+}
+
+/* Streaming over memory-mapped files
+ *
+ * jit.Function.stream_mmap(path, record_type, chunk_records=0, prefetch=True)
+ * maps the file at `path' read-only and applies the function to consecutive
+ * chunks of `chunk_records' records of type `record_type'. The function must
+ * take a pointer to the first record of a chunk and the number of records in
+ * it (as jit.Type.NINT or jit.Type.NUINT). If it returns an integer, the sum of
+ * its results over all chunks is returned, otherwise the number of records
+ * processed. The GIL is released while the chunks are processed. With
+ * `prefetch', the kernel is told that the mapping is read sequentially and
+ * each chunk is requested ahead of time while the previous one is processed.
+ */
+
+/* Default chunk size, chosen to keep a chunk in the L2 cache. */
+#define PYJIT_STREAM_CHUNK_BYTES (256 * 1024)
+
+static int
+_function_stream_check_signature(jit_type_t signature, int *return_kind)
+{
+    int kind;
+
+    if (jit_type_num_params(signature) != 2)
+        goto error;
+    kind = jit_type_get_kind(
+        jit_type_remove_tags(jit_type_get_param(signature, 0)));
+    if (kind != JIT_TYPE_PTR)
+        goto error;
+    kind = jit_type_get_kind(
+        jit_type_remove_tags(jit_type_get_param(signature, 1)));
+    if (kind != JIT_TYPE_NINT && kind != JIT_TYPE_NUINT)
+        goto error;
+
+    *return_kind = jit_type_get_kind(
+        jit_type_remove_tags(jit_type_get_return(signature)));
+    switch (*return_kind) {
+    case JIT_TYPE_VOID:
+    case JIT_TYPE_SBYTE:
+    case JIT_TYPE_UBYTE:
+    case JIT_TYPE_SHORT:
+    case JIT_TYPE_USHORT:
+    case JIT_TYPE_INT:
+    case JIT_TYPE_UINT:
+    case JIT_TYPE_NINT:
+    case JIT_TYPE_NUINT:
+    case JIT_TYPE_LONG:
+    case JIT_TYPE_ULONG:
+        return 0;
+    }
+
+error:
+    PyErr_SetString(PyExc_TypeError,
+                    "function must take a pointer and a record count and "
+                    "return nothing or an integer");
+    return -1;
+}
+
+static jit_long
+_function_stream_result(int kind, const void *result)
+{
+    switch (kind) {
+    case JIT_TYPE_SBYTE:
+        return *(const jit_sbyte *)result;
+    case JIT_TYPE_UBYTE:
+        return *(const jit_ubyte *)result;
+    case JIT_TYPE_SHORT:
+        return *(const jit_short *)result;
+    case JIT_TYPE_USHORT:
+        return *(const jit_ushort *)result;
+    case JIT_TYPE_INT:
+        return *(const jit_int *)result;
+    case JIT_TYPE_UINT:
+        return *(const jit_uint *)result;
+    case JIT_TYPE_NINT:
+        return *(const jit_nint *)result;
+    case JIT_TYPE_NUINT:
+        return (jit_long)*(const jit_nuint *)result;
+    case JIT_TYPE_LONG:
+        return *(const jit_long *)result;
+    case JIT_TYPE_ULONG:
+        return (jit_long)*(const jit_ulong *)result;
+    }
+    return 0;
+}
+
+static void
+_function_stream_prefetch(char *base, size_t length, size_t offset,
+                          size_t size, size_t page_size)
+{
+    size_t start = offset & ~(page_size - 1);
+
+    if (offset + size > length)
+        size = length - offset;
+    posix_madvise(base + start, size + (offset - start), POSIX_MADV_WILLNEED);
+}
+
+static PyObject *
+function_stream_mmap(PyJitFunction *self, PyObject *args, PyObject *kwargs)
+{
+    const char *path;
+    PyObject *record_type = NULL, *prefetch = NULL;
+    PyJitType *jit_record_type;
+    Py_ssize_t chunk_records = 0;
+    size_t record_size, length, num_records, offset, page_size;
+    jit_long total = 0, result = 0;
+    int fd, return_kind, do_prefetch = 1, ok = 1;
+    struct stat st;
+    char *base = NULL;
+    static char *kwlist[] = {
+        "path", "record_type", "chunk_records", "prefetch", NULL
+    };
+
+    if (PyJitFunction_Verify(self) < 0)
+        return NULL;
+
+    if (!jit_function_is_compiled(self->function)) {
+        PyErr_SetString(PyExc_ValueError, "function is not compiled");
+        return NULL;
+    }
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|nO:Function", kwlist,
+                                     &path, &record_type, &chunk_records,
+                                     &prefetch))
+        return NULL;
+
+    jit_record_type = PyJitType_Cast(record_type);
+    if (!jit_record_type) {
+        return pyjit_raise_type_error("record_type", pyjit_type_get_pytype(),
+                                      record_type);
+    }
+    record_size = jit_type_get_size(jit_record_type->type);
+    if (record_size == 0) {
+        PyErr_SetString(PyExc_ValueError, "record_type must not be empty");
+        return NULL;
+    }
+    if (chunk_records < 0) {
+        PyErr_SetString(PyExc_ValueError, "chunk_records must not be negative");
+        return NULL;
+    }
+    if (chunk_records == 0) {
+        chunk_records = PYJIT_STREAM_CHUNK_BYTES / record_size;
+        if (chunk_records == 0)
+            chunk_records = 1;
+    }
+    if (prefetch) {
+        do_prefetch = PyObject_IsTrue(prefetch);
+        if (do_prefetch < 0)
+            return NULL;
+    }
+
+    if (_function_stream_check_signature(
+            jit_function_get_signature(self->function), &return_kind) < 0)
+        return NULL;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return PyErr_SetFromErrnoWithFilename(PyExc_IOError, (char *)path);
+    if (fstat(fd, &st) < 0) {
+        PyErr_SetFromErrnoWithFilename(PyExc_IOError, (char *)path);
+        close(fd);
+        return NULL;
+    }
+    length = (size_t)st.st_size;
+    if (length % record_size) {
+        PyErr_Format(PyExc_ValueError,
+                     "file size is not a multiple of the record size %lu",
+                     (unsigned long)record_size);
+        close(fd);
+        return NULL;
+    }
+    num_records = length / record_size;
+    if (length) {
+        base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            PyErr_SetFromErrnoWithFilename(PyExc_IOError, (char *)path);
+            close(fd);
+            return NULL;
+        }
+    }
+    /* The mapping stays valid after closing the descriptor. */
+    close(fd);
+
+    page_size = (size_t)sysconf(_SC_PAGESIZE);
+    if (base && do_prefetch)
+        posix_madvise(base, length, POSIX_MADV_SEQUENTIAL);
+
+    Py_BEGIN_ALLOW_THREADS
+    jit_exception_set_handler(pyjit_exception_handler);
+    for (offset = 0; offset < num_records; offset += chunk_records) {
+        void *pointer = base + offset * record_size;
+        jit_nint count = (jit_nint)chunk_records;
+        void *jit_args[2];
+
+        if ((size_t)count > num_records - offset)
+            count = (jit_nint)(num_records - offset);
+        if (do_prefetch && offset + chunk_records < num_records) {
+            _function_stream_prefetch(
+                base, length, (offset + chunk_records) * record_size,
+                (size_t)chunk_records * record_size, page_size);
+        }
+
+        jit_args[0] = &pointer;
+        jit_args[1] = &count;
+        if (!jit_function_apply(self->function, jit_args, &result)) {
+            ok = 0;
+            break;
+        }
+        if (return_kind == JIT_TYPE_VOID)
+            total += count;
+        else
+            total += _function_stream_result(return_kind, &result);
+    }
+    Py_END_ALLOW_THREADS
+
+    if (base)
+        munmap(base, length);
+
+    if (!ok)
+        return pyjit_raise_thrown_exception();
+    return PyLong_FromLongLong(total);
+}
+
 static PyMethodDef function_methods[] = {
+    PYJIT_METHOD_NOARGS(function, abandon),
     PYJIT_METHOD_NOARGS(function, get_context),
     PYJIT_METHOD_NOARGS(function, get_signature),
     PYJIT_METHOD_KW(function, set_meta),
@@ -593,8 +1383,8 @@ static PyMethodDef function_methods[] = {
     PYJIT_METHOD_NOARGS(function, to_closure),
     /* jit_function_from_closure */
     /* jit_function_from_pc */
-    /* jit_function_to_vtable_pointer */
-    /* jit_function_from_vtable_pointer */
+    PYJIT_METHOD_NOARGS(function, to_vtable_pointer),
+    PYJIT_STATIC_METHOD_KW(function, from_vtable_pointer),
     /* jit_function_set_on_demand_compiler */
     /* jit_function_get_on_demand_compiler */
     PYJIT_METHOD_EX("apply_", function_apply, METH_KEYWORDS),
@@ -607,8 +1397,11 @@ static PyMethodDef function_methods[] = {
     /* jit_optimize */
     /* jit_compile */
     /* jit_compile_entry */
-    /* jit_function_setup_entry */
+    PYJIT_METHOD_KW(function, setup_entry),
     PYJIT_METHOD_EX("compile_", function_compile, METH_NOARGS),
+    PYJIT_METHOD_KW(function, loop),
+    PYJIT_METHOD_KW(function, select),
+    PYJIT_METHOD_KW(function, stream_mmap),
     /* jit_function_compile_entry */
 
     /* Re-exported methods originally belonging in jit.Value */
@@ -680,6 +1473,15 @@ static PyMethodDef function_methods[] = {
     PYJIT_METHOD_KW(function, insn_max),
     PYJIT_METHOD_KW(function, insn_sign),
     /* ... */
+    PYJIT_METHOD_KW(function, insn_call),
+    PYJIT_METHOD_KW(function, insn_call_indirect),
+    PYJIT_METHOD_KW(function, insn_call_indirect_vtable),
+    PYJIT_METHOD_KW(function, insn_call_native),
+    PYJIT_METHOD_KW(function, insn_memcpy),
+    PYJIT_METHOD_KW(function, insn_memmove),
+    PYJIT_METHOD_KW(function, insn_memset),
+    PYJIT_METHOD_KW(function, insn_alloca),
+    PYJIT_METHOD_KW(function, insn_jump_table),
     PYJIT_METHOD_KW(function, insn_return),
     /* ... */
     { NULL } /* Sentinel */
@@ -751,6 +1553,37 @@ pyjit_function_get_pytype(void)
     return &PyJitFunction_Type;
 }
 
+/* Keep `o' alive until the builder of `function' is discarded. */
+int
+pyjit_function_keep_alive(jit_function_t function, PyObject *o)
+{
+    PyObject *objects;
+
+    objects = (PyObject *)jit_function_get_meta(function, PYJIT_META_KEEPALIVE);
+    if (!objects) {
+        objects = PyList_New(0);
+        if (!objects)
+            return -1;
+        if (!jit_function_set_meta(function, PYJIT_META_KEEPALIVE, objects,
+                                   pyjit_meta_free_func, 1)) {
+            Py_DECREF(objects);
+            PyErr_SetString(PyExc_MemoryError,
+                            "memory allocation inside LibJIT failed");
+            return -1;
+        }
+    }
+    return PyList_Append(objects, o);
+}
+
+/* Like PyJitFunction_New but returns NULL without setting an exception if
+ * there is no wrapper for `function', e.g. because it has been deallocated.
+ */
+PyObject *
+pyjit_function_get_cached(jit_function_t function)
+{
+    return pyjit_weak_cache_getitem(function_cache, (long)function);
+}
+
 PyObject *
 PyJitFunction_New(jit_function_t function)
 {
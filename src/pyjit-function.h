@@ -26,8 +26,15 @@ typedef struct {
     PyObject *weakreflist;
 } PyJitFunction;
 
+/* Function metadata type under which objects are kept alive that LibJIT
+ * references without copying while a function is being built.
+ */
+#define PYJIT_META_KEEPALIVE 9999
+
 int pyjit_function_init(PyObject *module);
 const PyTypeObject *pyjit_function_get_pytype(void);
+PyObject *pyjit_function_get_cached(jit_function_t function);
+int pyjit_function_keep_alive(jit_function_t function, PyObject *o);
 PyObject *PyJitFunction_New(jit_function_t function);
 int PyJitFunction_Check(PyObject *o);
 PyJitFunction *PyJitFunction_Cast(PyObject *o);
@@ -57,19 +57,13 @@ insn_get_opcode(PyJitInsn *self)
     return PyInt_FromLong(jit_insn_get_opcode(self->insn));
 }
 
-static PyObject *insn_get_function(PyJitInsn *self); /* Forward */
-
+/* Operands belong to the function containing the instruction, not to the
+ * callee reported by jit_insn_get_function for call instructions.
+ */
 static PyObject *
 _value_new(PyJitInsn *self, jit_value_t value)
 {
-    PyObject *function, *retval;
-
-    function = insn_get_function(self);
-    if (!function)
-        return NULL;
-    retval = PyJitValue_New(value, function);
-    Py_DECREF(function);
-    return retval;
+    return PyJitValue_New(value, self->function);
 }
 
 static PyObject *
@@ -99,7 +93,7 @@ insn_get_value2(PyJitInsn *self)
 {
     jit_value_t value2;
 
-    value2 = jit_insn_get_value1(self->insn);
+    value2 = jit_insn_get_value2(self->insn);
     if (!value2)
         Py_RETURN_NONE;
     return _value_new(self, value2);
@@ -123,6 +117,15 @@ insn_get_function(PyJitInsn *self)
     return PyJitFunction_New(function);
 }
 
+static PyObject *
+insn_get_native(PyJitInsn *self)
+{
+    void *native = jit_insn_get_native(self->insn);
+    if (!native)
+        Py_RETURN_NONE;
+    return PyLong_FromVoidPtr(native);
+}
+
 static PyObject *
 insn_get_name(PyJitInsn *self)
 {
@@ -182,6 +185,8 @@ insn_label(void *null, PyObject *args, PyObject *kwargs)
     if (_insn_label_prelude(args, kwargs, &jit_function, &jit_label) < 0)
         return NULL;
     jit_insn_label(jit_function->function, &jit_label->label);
+    if (pyjit_label_register(jit_label) < 0)
+        return NULL;
     Py_RETURN_NONE;
 }
 
@@ -253,7 +258,7 @@ insn_store(void *null, PyObject *args, PyObject *kwargs)
     PyJitValue *jit_value_dest, *jit_value;
     static char *kwlist[] = { "func", "dest", "value", NULL };
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO:Insn", kwlist, &func,
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO:Insn", kwlist, &func,
                                      &dest, &value))
         return NULL;
 
@@ -475,7 +480,7 @@ insn_store_elem(void *null, PyObject *args, PyObject *kwargs)
             ((PyJitValue *)value)->value));
 }
 
-/* TODO: jit_insn_flush_struct, jit_insn_push, jit_insn_return, jit_insn_throw,
+/* TODO: jit_insn_flush_struct, jit_insn_push, jit_insn_return,
  *       and jit_insn_return from filter have the same signature as
  *       jit_insn_check_null.
  */
@@ -610,10 +615,14 @@ insn_branch(void *null, PyObject *args, PyObject *kwargs)
     PyJitFunction *jit_function;
     PyJitLabel *jit_label;
 
+    int r;
+
     if (_insn_label_prelude(args, kwargs, &jit_function, &jit_label) < 0)
         return NULL;
-    return PyBool_FromLong(
-        jit_insn_branch(jit_function->function, &jit_label->label));
+    r = jit_insn_branch(jit_function->function, &jit_label->label);
+    if (pyjit_label_register(jit_label) < 0)
+        return NULL;
+    return PyBool_FromLong(r);
 }
 
 static PyObject *
@@ -625,6 +634,7 @@ _insn_branch_conditionally(
     PyJitFunction *jit_function;
     PyJitValue *jit_value;
     PyJitLabel *jit_label;
+    int r;
     static char *kwlist[] = { "func", "value", "label", NULL };
 
     if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO:Insn", kwlist, &func,
@@ -648,9 +658,11 @@ _insn_branch_conditionally(
         return pyjit_raise_type_error("label", pyjit_label_get_pytype(),
                                       label);
     }
-    return PyBool_FromLong(
-        branchfunc(jit_function->function, jit_value->value,
-                   &jit_label->label));
+    r = branchfunc(jit_function->function, jit_value->value,
+                   &jit_label->label);
+    if (pyjit_label_register(jit_label) < 0)
+        return NULL;
+    return PyBool_FromLong(r);
 }
 
 static PyObject *
@@ -676,11 +688,85 @@ insn_address_of_label(void *null, PyObject *args, PyObject *kwargs)
     PyJitFunction *jit_function;
     PyJitLabel *jit_label;
 
+    jit_value_t value;
+
     if (_insn_label_prelude(args, kwargs, &jit_function, &jit_label) < 0)
         return NULL;
-    return PyJitValue_New(
-        jit_insn_address_of_label(jit_function->function, &jit_label->label),
-        (PyObject *)jit_function);
+    value = jit_insn_address_of_label(jit_function->function,
+                                      &jit_label->label);
+    if (pyjit_label_register(jit_label) < 0)
+        return NULL;
+    return PyJitValue_New(value, (PyObject *)jit_function);
+}
+
+PyObject *
+pyjit_insn_jump_table(void *null, PyObject *args, PyObject *kwargs)
+{
+    PyObject *func = NULL, *value = NULL, *labels = NULL, *seq, *retval = NULL;
+    PyJitFunction *jit_function;
+    PyJitValue *jit_value;
+    Py_ssize_t i, num_labels;
+    jit_label_t *jit_labels;
+    int r;
+    static char *kwlist[] = { "func", "value", "labels", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO:Insn", kwlist, &func,
+                                     &value, &labels))
+        return NULL;
+
+    jit_function = PyJitFunction_CastAndVerify(func);
+    if (!jit_function)
+        return NULL;
+
+    jit_value = PyJitValue_Cast(value);
+    if (!jit_value) {
+        return pyjit_raise_type_error("value", pyjit_value_get_pytype(),
+                                      value);
+    }
+
+    seq = PySequence_Fast(labels, "labels must be a sequence");
+    if (!seq)
+        return NULL;
+    num_labels = PySequence_Fast_GET_SIZE(seq);
+    if (num_labels == 0) {
+        PyErr_SetString(PyExc_ValueError, "labels must not be empty");
+        goto out;
+    }
+
+    jit_labels = PyMem_New(jit_label_t, num_labels);
+    if (!jit_labels) {
+        PyErr_NoMemory();
+        goto out;
+    }
+    for (i = 0; i < num_labels; i++) {
+        PyObject *item = PySequence_Fast_GET_ITEM(seq, i);
+        PyJitLabel *jit_label = PyJitLabel_Cast(item);
+        if (!jit_label) {
+            pyjit_raise_type_error("labels", pyjit_label_get_pytype(), item);
+            PyMem_Free(jit_labels);
+            goto out;
+        }
+        jit_labels[i] = jit_label->label;
+    }
+
+    /* LibJIT assigns numbers to undefined labels, so copy them back. */
+    r = jit_insn_jump_table(jit_function->function, jit_value->value,
+                            jit_labels, (unsigned int)num_labels);
+    for (i = 0; i < num_labels; i++) {
+        PyJitLabel *jit_label =
+            (PyJitLabel *)PySequence_Fast_GET_ITEM(seq, i);
+        jit_label->label = jit_labels[i];
+        if (pyjit_label_register(jit_label) < 0) {
+            PyMem_Free(jit_labels);
+            goto out;
+        }
+    }
+    PyMem_Free(jit_labels);
+    retval = PyBool_FromLong(r);
+
+out:
+    Py_DECREF(seq);
+    return retval;
 }
 
 static PyObject *
@@ -725,12 +811,598 @@ insn_convert(void *null, PyObject *args, PyObject *kwargs)
     return PyJitValue_New(converted_value, func);
 }
 
+/* Function calls */
+
+/* Convert the sequence `args' of jit.Value objects to an array which the
+ * caller has to release with PyMem_Free. The number of arguments is checked
+ * against `signature'.
+ */
+static int
+_insn_call_args(PyObject *args, jit_type_t signature, jit_value_t **values,
+                unsigned int *num_values)
+{
+    PyObject *seq;
+    Py_ssize_t i, n;
+    unsigned int num_params;
+
+    if (!jit_type_is_signature(signature)) {
+        PyErr_SetString(PyExc_ValueError, "signature must be a signature type");
+        return -1;
+    }
+
+    seq = PySequence_Fast(args, "args must be a sequence");
+    if (!seq)
+        return -1;
+    n = PySequence_Fast_GET_SIZE(seq);
+
+    num_params = jit_type_num_params(signature);
+    if ((unsigned int)n != num_params &&
+        !(jit_type_get_abi(signature) == jit_abi_vararg &&
+          (unsigned int)n > num_params)) {
+        PyErr_Format(PyExc_TypeError, "function expected %u arguments, got %u",
+                     num_params, (unsigned int)n);
+        Py_DECREF(seq);
+        return -1;
+    }
+
+    *values = PyMem_New(jit_value_t, n > 0 ? n : 1);
+    if (!*values) {
+        Py_DECREF(seq);
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (i = 0; i < n; i++) {
+        PyObject *item = PySequence_Fast_GET_ITEM(seq, i);
+        PyJitValue *jit_value = PyJitValue_Cast(item);
+        if (!jit_value) {
+            pyjit_raise_type_error("args", pyjit_value_get_pytype(), item);
+            PyMem_Free(*values);
+            Py_DECREF(seq);
+            return -1;
+        }
+        (*values)[i] = jit_value->value;
+    }
+    *num_values = (unsigned int)n;
+
+    Py_DECREF(seq);
+    return 0;
+}
+
+/* LibJIT stores the name of call instructions without copying it. */
+static int
+_insn_call_name(PyJitFunction *jit_function, PyObject *name,
+                const char **jit_name)
+{
+    if (name == Py_None) {
+        *jit_name = NULL;
+        return 0;
+    }
+    if (!PyString_Check(name)) {
+        PyErr_Format(PyExc_TypeError, "name must be a string, not %.100s",
+                     Py_TYPE(name)->tp_name);
+        return -1;
+    }
+    if (pyjit_function_keep_alive(jit_function->function, name) < 0)
+        return -1;
+    *jit_name = PyString_AS_STRING(name);
+    return 0;
+}
+
+static PyObject *
+_insn_call_result(PyObject *func, jit_value_t value)
+{
+    if (!value) {
+        PyErr_SetString(PyExc_MemoryError,
+                        "memory allocation inside LibJIT failed");
+        return NULL;
+    }
+    return PyJitValue_New(value, func);
+}
+
+PyObject *
+pyjit_insn_call(void *null, PyObject *args, PyObject *kwargs)
+{
+    PyObject *func = NULL, *name = NULL, *jit_func = NULL, *signature = NULL,
+             *call_args = NULL;
+    int flags = 0;
+    const char *jit_name;
+    PyJitFunction *jit_function, *jit_callee;
+    jit_type_t jit_signature;
+    jit_value_t *values, value;
+    unsigned int num_values;
+    static char *kwlist[] = {
+        "func", "name", "jit_func", "signature", "args", "flags", NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOOO|i:Insn", kwlist,
+                                     &func, &name, &jit_func, &signature,
+                                     &call_args, &flags))
+        return NULL;
+
+    jit_function = PyJitFunction_CastAndVerify(func);
+    if (!jit_function)
+        return NULL;
+    jit_callee = PyJitFunction_CastAndVerify(jit_func);
+    if (!jit_callee)
+        return NULL;
+
+    /* Default to the signature of the callee. */
+    if (signature == Py_None) {
+        jit_signature = jit_function_get_signature(jit_callee->function);
+    }
+    else {
+        PyJitType *jit_type = PyJitType_Cast(signature);
+        if (!jit_type) {
+            return pyjit_raise_type_error(
+                "signature", pyjit_type_get_pytype(), signature);
+        }
+        jit_signature = jit_type->type;
+    }
+
+    if (_insn_call_name(jit_function, name, &jit_name) < 0)
+        return NULL;
+    if (_insn_call_args(call_args, jit_signature, &values, &num_values) < 0)
+        return NULL;
+
+    value = jit_insn_call(jit_function->function, jit_name,
+                          jit_callee->function, jit_signature, values,
+                          num_values, flags);
+    PyMem_Free(values);
+    return _insn_call_result(func, value);
+}
+
+static PyObject *
+_insn_call_indirect(
+    PyObject *args, PyObject *kwargs,
+    jit_value_t (*callfunc)(jit_function_t, jit_value_t, jit_type_t,
+                            jit_value_t *, unsigned int, int))
+{
+    PyObject *func = NULL, *value = NULL, *signature = NULL,
+             *call_args = NULL;
+    int flags = 0;
+    PyJitFunction *jit_function;
+    PyJitValue *jit_value;
+    PyJitType *jit_signature;
+    jit_value_t *values, retval;
+    unsigned int num_values;
+    static char *kwlist[] = {
+        "func", "value", "signature", "args", "flags", NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOO|i:Insn", kwlist,
+                                     &func, &value, &signature, &call_args,
+                                     &flags))
+        return NULL;
+
+    jit_function = PyJitFunction_CastAndVerify(func);
+    if (!jit_function)
+        return NULL;
+    jit_value = PyJitValue_Cast(value);
+    if (!jit_value) {
+        return pyjit_raise_type_error("value", pyjit_value_get_pytype(),
+                                      value);
+    }
+    jit_signature = PyJitType_Cast(signature);
+    if (!jit_signature) {
+        return pyjit_raise_type_error("signature", pyjit_type_get_pytype(),
+                                      signature);
+    }
+
+    if (_insn_call_args(call_args, jit_signature->type, &values,
+                        &num_values) < 0)
+        return NULL;
+
+    retval = callfunc(jit_function->function, jit_value->value,
+                      jit_signature->type, values, num_values, flags);
+    PyMem_Free(values);
+    return _insn_call_result(func, retval);
+}
+
+PyObject *
+pyjit_insn_call_indirect(void *null, PyObject *args, PyObject *kwargs)
+{
+    return _insn_call_indirect(args, kwargs, jit_insn_call_indirect);
+}
+
+PyObject *
+pyjit_insn_call_indirect_vtable(void *null, PyObject *args, PyObject *kwargs)
+{
+    return _insn_call_indirect(args, kwargs, jit_insn_call_indirect_vtable);
+}
+
+PyObject *
+pyjit_insn_call_native(void *null, PyObject *args, PyObject *kwargs)
+{
+    PyObject *func = NULL, *name = NULL, *native_func = NULL,
+             *signature = NULL, *call_args = NULL;
+    int flags = 0;
+    const char *jit_name;
+    void *native;
+    PyJitFunction *jit_function;
+    PyJitType *jit_signature;
+    jit_value_t *values, value;
+    unsigned int num_values;
+    static char *kwlist[] = {
+        "func", "name", "native_func", "signature", "args", "flags", NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOOO|i:Insn", kwlist,
+                                     &func, &name, &native_func, &signature,
+                                     &call_args, &flags))
+        return NULL;
+
+    jit_function = PyJitFunction_CastAndVerify(func);
+    if (!jit_function)
+        return NULL;
+
+    native = PyLong_AsVoidPtr(native_func);
+    if (!native) {
+        if (!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "native_func must not be NULL");
+        return NULL;
+    }
+
+    jit_signature = PyJitType_Cast(signature);
+    if (!jit_signature) {
+        return pyjit_raise_type_error("signature", pyjit_type_get_pytype(),
+                                      signature);
+    }
+
+    if (_insn_call_name(jit_function, name, &jit_name) < 0)
+        return NULL;
+    if (_insn_call_args(call_args, jit_signature->type, &values,
+                        &num_values) < 0)
+        return NULL;
+
+    value = jit_insn_call_native(jit_function->function, jit_name, native,
+                                 jit_signature->type, values, num_values,
+                                 flags);
+    PyMem_Free(values);
+    return _insn_call_result(func, value);
+}
+
+/* Memory operations */
+
+/* Accept either a jit.Value or a Python integer, which is converted to a
+ * constant of type `type'.
+ */
+static int
+_insn_value_or_constant(jit_function_t function, PyObject *o, jit_type_t type,
+                        const char *arg_name, jit_value_t *value)
+{
+    PyJitValue *jit_value;
+
+    if (PyInt_Check(o) || PyLong_Check(o)) {
+        jit_nint constant = PyLong_AsLong(o);
+        if (constant == -1 && PyErr_Occurred())
+            return -1;
+        *value = jit_value_create_nint_constant(function, type, constant);
+        if (!*value) {
+            PyErr_SetString(PyExc_MemoryError,
+                            "memory allocation inside LibJIT failed");
+            return -1;
+        }
+        return 0;
+    }
+
+    jit_value = PyJitValue_Cast(o);
+    if (!jit_value) {
+        pyjit_raise_type_error(arg_name, pyjit_value_get_pytype(), o);
+        return -1;
+    }
+    *value = jit_value->value;
+    return 0;
+}
+
+static PyObject *
+_insn_memory_op(
+    PyObject *args, PyObject *kwargs, const char *value_name, int fill,
+    int (*memfunc)(jit_function_t, jit_value_t, jit_value_t, jit_value_t))
+{
+    PyObject *func = NULL, *dest = NULL, *value = NULL, *size = NULL;
+    PyJitFunction *jit_function;
+    PyJitValue *jit_dest;
+    jit_value_t jit_value, jit_size;
+    char *kwlist[] = { "func", "dest", NULL, "size", NULL };
+
+    kwlist[2] = (char *)value_name;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOO:Insn", kwlist, &func,
+                                     &dest, &value, &size))
+        return NULL;
+
+    jit_function = PyJitFunction_CastAndVerify(func);
+    if (!jit_function)
+        return NULL;
+
+    jit_dest = PyJitValue_Cast(dest);
+    if (!jit_dest)
+        return pyjit_raise_type_error("dest", pyjit_value_get_pytype(), dest);
+
+    /* For memset, the fill value may be an int; otherwise it's a source
+     * pointer which has to be a jit.Value.
+     */
+    if (fill) {
+        if (_insn_value_or_constant(jit_function->function, value,
+                                    jit_type_int, value_name,
+                                    &jit_value) < 0)
+            return NULL;
+    }
+    else {
+        PyJitValue *jit_src = PyJitValue_Cast(value);
+        if (!jit_src) {
+            return pyjit_raise_type_error(value_name,
+                                          pyjit_value_get_pytype(), value);
+        }
+        jit_value = jit_src->value;
+    }
+
+    if (_insn_value_or_constant(jit_function->function, size, jit_type_nuint,
+                                "size", &jit_size) < 0)
+        return NULL;
+
+    return PyBool_FromLong(
+        memfunc(jit_function->function, jit_dest->value, jit_value,
+                jit_size));
+}
+
+PyObject *
+pyjit_insn_memcpy(void *null, PyObject *args, PyObject *kwargs)
+{
+    return _insn_memory_op(args, kwargs, "src", 0, jit_insn_memcpy);
+}
+
+PyObject *
+pyjit_insn_memmove(void *null, PyObject *args, PyObject *kwargs)
+{
+    return _insn_memory_op(args, kwargs, "src", 0, jit_insn_memmove);
+}
+
+PyObject *
+pyjit_insn_memset(void *null, PyObject *args, PyObject *kwargs)
+{
+    return _insn_memory_op(args, kwargs, "value", 1, jit_insn_memset);
+}
+
+PyObject *
+pyjit_insn_alloca(void *null, PyObject *args, PyObject *kwargs)
+{
+    PyObject *func = NULL, *size = NULL;
+    PyJitFunction *jit_function;
+    jit_value_t jit_size, value;
+    static char *kwlist[] = { "func", "size", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO:Insn", kwlist, &func,
+                                     &size))
+        return NULL;
+
+    jit_function = PyJitFunction_CastAndVerify(func);
+    if (!jit_function)
+        return NULL;
+
+    if (_insn_value_or_constant(jit_function->function, size, jit_type_nuint,
+                                "size", &jit_size) < 0)
+        return NULL;
+
+    value = jit_insn_alloca(jit_function->function, jit_size);
+    if (!value) {
+        PyErr_SetString(PyExc_MemoryError,
+                        "memory allocation inside LibJIT failed");
+        return NULL;
+    }
+    return PyJitValue_New(value, func);
+}
+
 static PyObject *
 insn_return(void *null, PyObject *args, PyObject *kwargs)
 {
     return _insn_func(args, kwargs, jit_insn_return);
 }
 
+/* Exception handling */
+static int
+_insn_func_prelude(PyObject *args, PyObject *kwargs,
+                   PyJitFunction **jit_function)
+{
+    PyObject *func = NULL;
+    static char *kwlist[] = { "func", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O:Insn", kwlist, &func))
+        return -1;
+
+    *jit_function = PyJitFunction_Cast(func);
+    if (!*jit_function) {
+        pyjit_raise_type_error("func", pyjit_function_get_pytype(), func);
+        return -1;
+    }
+    return 0;
+}
+
+#define DEFINE_FUNC_VALUE_METHOD(name)                                  \
+static PyObject *                                                       \
+insn_##name(void *null, PyObject *args, PyObject *kwargs)               \
+{                                                                       \
+    PyJitFunction *jit_function;                                        \
+                                                                        \
+    if (_insn_func_prelude(args, kwargs, &jit_function) < 0)            \
+        return NULL;                                                    \
+    return PyJitValue_New(jit_insn_##name(jit_function->function),      \
+                          (PyObject *)jit_function);                    \
+}
+
+#define DEFINE_FUNC_BOOLEAN_METHOD(name)                                \
+static PyObject *                                                       \
+insn_##name(void *null, PyObject *args, PyObject *kwargs)               \
+{                                                                       \
+    PyJitFunction *jit_function;                                        \
+                                                                        \
+    if (_insn_func_prelude(args, kwargs, &jit_function) < 0)            \
+        return NULL;                                                    \
+    return PyBool_FromLong(jit_insn_##name(jit_function->function));    \
+}
+
+#define DEFINE_FUNC_LABEL_METHOD(name)                                  \
+static PyObject *                                                       \
+insn_##name(void *null, PyObject *args, PyObject *kwargs)               \
+{                                                                       \
+    PyJitFunction *jit_function;                                        \
+    PyJitLabel *jit_label;                                              \
+    int r;                                                              \
+                                                                        \
+    if (_insn_label_prelude(args, kwargs, &jit_function, &jit_label) < 0) \
+        return NULL;                                                    \
+    r = jit_insn_##name(jit_function->function, &jit_label->label);     \
+    if (pyjit_label_register(jit_label) < 0)                            \
+        return NULL;                                                    \
+    return PyBool_FromLong(r);                                          \
+}
+
+static PyObject *
+insn_throw(void *null, PyObject *args, PyObject *kwargs)
+{
+    return _insn_func(args, kwargs, jit_insn_throw);
+}
+
+DEFINE_FUNC_VALUE_METHOD(get_call_stack)
+DEFINE_FUNC_VALUE_METHOD(thrown_exception)
+DEFINE_FUNC_BOOLEAN_METHOD(uses_catcher)
+DEFINE_FUNC_VALUE_METHOD(start_catcher)
+
+static PyObject *
+insn_branch_if_pc_not_in_range(void *null, PyObject *args, PyObject *kwargs)
+{
+    PyObject *func = NULL, *start_label = NULL, *end_label = NULL,
+             *label = NULL;
+    PyJitFunction *jit_function;
+    PyJitLabel *jit_start_label, *jit_end_label, *jit_label;
+    int r;
+    static char *kwlist[] = {
+        "func", "start_label", "end_label", "label", NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOO:Insn", kwlist, &func,
+                                     &start_label, &end_label, &label))
+        return NULL;
+
+    jit_function = PyJitFunction_Cast(func);
+    if (!jit_function) {
+        return pyjit_raise_type_error("func", pyjit_function_get_pytype(),
+                                      func);
+    }
+    jit_start_label = PyJitLabel_Cast(start_label);
+    if (!jit_start_label) {
+        return pyjit_raise_type_error("start_label", pyjit_label_get_pytype(),
+                                      start_label);
+    }
+    jit_end_label = PyJitLabel_Cast(end_label);
+    if (!jit_end_label) {
+        return pyjit_raise_type_error("end_label", pyjit_label_get_pytype(),
+                                      end_label);
+    }
+    jit_label = PyJitLabel_Cast(label);
+    if (!jit_label) {
+        return pyjit_raise_type_error("label", pyjit_label_get_pytype(),
+                                      label);
+    }
+
+    r = jit_insn_branch_if_pc_not_in_range(
+        jit_function->function, jit_start_label->label, jit_end_label->label,
+        &jit_label->label);
+    if (pyjit_label_register(jit_label) < 0)
+        return NULL;
+    return PyBool_FromLong(r);
+}
+
+DEFINE_FUNC_BOOLEAN_METHOD(rethrow_unhandled)
+DEFINE_FUNC_LABEL_METHOD(start_finally)
+DEFINE_FUNC_BOOLEAN_METHOD(return_from_finally)
+DEFINE_FUNC_LABEL_METHOD(call_finally)
+
+static PyObject *
+insn_start_filter(void *null, PyObject *args, PyObject *kwargs)
+{
+    PyObject *func = NULL, *label = NULL, *type = NULL;
+    PyJitFunction *jit_function;
+    PyJitLabel *jit_label;
+    PyJitType *jit_type;
+    jit_value_t value;
+    static char *kwlist[] = { "func", "label", "type_", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO:Insn", kwlist, &func,
+                                     &label, &type))
+        return NULL;
+
+    jit_function = PyJitFunction_Cast(func);
+    if (!jit_function) {
+        return pyjit_raise_type_error("func", pyjit_function_get_pytype(),
+                                      func);
+    }
+    jit_label = PyJitLabel_Cast(label);
+    if (!jit_label) {
+        return pyjit_raise_type_error("label", pyjit_label_get_pytype(),
+                                      label);
+    }
+    jit_type = PyJitType_Cast(type);
+    if (!jit_type)
+        return pyjit_raise_type_error("type_", pyjit_type_get_pytype(), type);
+
+    value = jit_insn_start_filter(jit_function->function, &jit_label->label,
+                                  jit_type->type);
+    if (pyjit_label_register(jit_label) < 0)
+        return NULL;
+    return PyJitValue_New(value, func);
+}
+
+static PyObject *
+insn_return_from_filter(void *null, PyObject *args, PyObject *kwargs)
+{
+    return _insn_func(args, kwargs, jit_insn_return_from_filter);
+}
+
+static PyObject *
+insn_call_filter(void *null, PyObject *args, PyObject *kwargs)
+{
+    PyObject *func = NULL, *label = NULL, *value = NULL, *type = NULL;
+    PyJitFunction *jit_function;
+    PyJitLabel *jit_label;
+    PyJitValue *jit_value;
+    PyJitType *jit_type;
+    jit_value_t retval;
+    static char *kwlist[] = { "func", "label", "value", "type_", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOO:Insn", kwlist, &func,
+                                     &label, &value, &type))
+        return NULL;
+
+    jit_function = PyJitFunction_Cast(func);
+    if (!jit_function) {
+        return pyjit_raise_type_error("func", pyjit_function_get_pytype(),
+                                      func);
+    }
+    jit_label = PyJitLabel_Cast(label);
+    if (!jit_label) {
+        return pyjit_raise_type_error("label", pyjit_label_get_pytype(),
+                                      label);
+    }
+    jit_value = PyJitValue_Cast(value);
+    if (!jit_value) {
+        return pyjit_raise_type_error("value", pyjit_value_get_pytype(),
+                                      value);
+    }
+    jit_type = PyJitType_Cast(type);
+    if (!jit_type)
+        return pyjit_raise_type_error("type_", pyjit_type_get_pytype(), type);
+
+    retval = jit_insn_call_filter(jit_function->function, &jit_label->label,
+                                  jit_value->value, jit_type->type);
+    if (pyjit_label_register(jit_label) < 0)
+        return NULL;
+    return PyJitValue_New(retval, func);
+}
+
+#undef DEFINE_FUNC_VALUE_METHOD
+#undef DEFINE_FUNC_BOOLEAN_METHOD
+#undef DEFINE_FUNC_LABEL_METHOD
+
 static PyMethodDef insn_methods[] = {
     PYJIT_METHOD_NOARGS(insn, get_opcode),
     PYJIT_METHOD_NOARGS(insn, get_dest),
@@ -738,7 +1410,7 @@ static PyMethodDef insn_methods[] = {
     PYJIT_METHOD_NOARGS(insn, get_value2),
     PYJIT_METHOD_NOARGS(insn, get_label),
     PYJIT_METHOD_NOARGS(insn, get_function),
-    /* PYJIT_METHOD_NOARGS(insn, get_native), */
+    PYJIT_METHOD_NOARGS(insn, get_native),
     PYJIT_METHOD_NOARGS(insn, get_name),
     PYJIT_METHOD_NOARGS(insn, get_signature),
     PYJIT_METHOD_NOARGS(insn, dest_is_value),
@@ -813,14 +1485,18 @@ static PyMethodDef insn_methods[] = {
     PYJIT_STATIC_METHOD_KW(insn, branch),
     PYJIT_STATIC_METHOD_KW(insn, branch_if),
     PYJIT_STATIC_METHOD_KW(insn, branch_if_not),
-    /* PYJIT_STATIC_METHOD_KW(insn, jump_table), */
+    PYJIT_METHOD_EX("jump_table", pyjit_insn_jump_table,
+                    METH_STATIC | METH_KEYWORDS),
     PYJIT_STATIC_METHOD_KW(insn, address_of),
     PYJIT_STATIC_METHOD_KW(insn, address_of_label),
     PYJIT_STATIC_METHOD_KW(insn, convert),
-    /* jit_insn_call */
-    /* jit_insn_call_indirect */
-    /* jit_insn_call_indirect_vtable */
-    /* jit_insn_call_native */
+    PYJIT_METHOD_EX("call", pyjit_insn_call, METH_STATIC | METH_KEYWORDS),
+    PYJIT_METHOD_EX("call_indirect", pyjit_insn_call_indirect,
+                    METH_STATIC | METH_KEYWORDS),
+    PYJIT_METHOD_EX("call_indirect_vtable", pyjit_insn_call_indirect_vtable,
+                    METH_STATIC | METH_KEYWORDS),
+    PYJIT_METHOD_EX("call_native", pyjit_insn_call_native,
+                    METH_STATIC | METH_KEYWORDS),
     /* jit_insn_call_intrinsic */
     /* jit_insn_incoming_reg */
     /* jit_insn_incoming_frame_posn */
@@ -841,23 +1517,24 @@ static PyMethodDef insn_methods[] = {
     PYJIT_METHOD_EX("return_", insn_return, METH_STATIC | METH_KEYWORDS),
     /* jit_insn_return_ptr */
     /* jit_insn_default_return */
-    /* jit_insn_throw */
-    /* jit_insn_get_call_stack */
-    /* jit_insn_thrown_exception */
-    /* jit_insn_uses_catcher */
-    /* jit_insn_start_catcher */
-    /* jit_insn_branch_if_pc_not_in_range */
-    /* jit_insn_rethrow_unhandled */
-    /* jit_insn_start_finally */
-    /* jit_insn_return_from_finally */
-    /* jit_insn_call_finally */
-    /* jit_insn_start_filter */
-    /* jit_insn_return_from_filter */
-    /* jit_insn_call_filter */
-    /* jit_insn_memcpy */
-    /* jit_insn_memmove */
-    /* jit_insn_memset */
-    /* jit_insn_alloca */
+    PYJIT_STATIC_METHOD_KW(insn, throw),
+    PYJIT_STATIC_METHOD_KW(insn, get_call_stack),
+    PYJIT_STATIC_METHOD_KW(insn, thrown_exception),
+    PYJIT_STATIC_METHOD_KW(insn, uses_catcher),
+    PYJIT_STATIC_METHOD_KW(insn, start_catcher),
+    PYJIT_STATIC_METHOD_KW(insn, branch_if_pc_not_in_range),
+    PYJIT_STATIC_METHOD_KW(insn, rethrow_unhandled),
+    PYJIT_STATIC_METHOD_KW(insn, start_finally),
+    PYJIT_STATIC_METHOD_KW(insn, return_from_finally),
+    PYJIT_STATIC_METHOD_KW(insn, call_finally),
+    PYJIT_STATIC_METHOD_KW(insn, start_filter),
+    PYJIT_STATIC_METHOD_KW(insn, return_from_filter),
+    PYJIT_STATIC_METHOD_KW(insn, call_filter),
+    PYJIT_METHOD_EX("memcpy", pyjit_insn_memcpy, METH_STATIC | METH_KEYWORDS),
+    PYJIT_METHOD_EX("memmove", pyjit_insn_memmove,
+                    METH_STATIC | METH_KEYWORDS),
+    PYJIT_METHOD_EX("memset", pyjit_insn_memset, METH_STATIC | METH_KEYWORDS),
+    PYJIT_METHOD_EX("alloca", pyjit_insn_alloca, METH_STATIC | METH_KEYWORDS),
     /* jit_insn_move_blocks_to_end */
     /* jit_insn_move_blocks_to_start */
     /* jit_insn_mark_offset */
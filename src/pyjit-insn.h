@@ -41,6 +41,20 @@ PyObject *pyjit_insn_binary_method(
     PyObject *func, PyObject *value1, PyObject *value2,
     pyjit_binaryfunc binaryfunc);
 
+/* Static methods of jit.Insn which are re-exported by jit.Function */
+PyObject *pyjit_insn_call(void *null, PyObject *args, PyObject *kwargs);
+PyObject *pyjit_insn_call_indirect(
+    void *null, PyObject *args, PyObject *kwargs);
+PyObject *pyjit_insn_call_indirect_vtable(
+    void *null, PyObject *args, PyObject *kwargs);
+PyObject *pyjit_insn_call_native(void *null, PyObject *args, PyObject *kwargs);
+PyObject *pyjit_insn_memcpy(void *null, PyObject *args, PyObject *kwargs);
+PyObject *pyjit_insn_memmove(void *null, PyObject *args, PyObject *kwargs);
+PyObject *pyjit_insn_memset(void *null, PyObject *args, PyObject *kwargs);
+PyObject *pyjit_insn_alloca(void *null, PyObject *args, PyObject *kwargs);
+PyObject *pyjit_insn_jump_table(void *null, PyObject *args,
+                                PyObject *kwargs);
+
 PyObject *PyJitInsn_New(jit_insn_t insn, PyObject *function);
 int PyJitInsn_Check(PyObject *o);
 PyJitInsn *PyJitInsn_Cast(PyObject *o);
@@ -14,8 +14,12 @@
  */
 
 #include "pyjit-abi.h"
+#include "pyjit-array.h"
+#include "pyjit-block.h"
 #include "pyjit-common.h"
 #include "pyjit-context.h"
+#include "pyjit-elf.h"
+#include "pyjit-except.h"
 #include "pyjit-function.h"
 #include "pyjit-insn.h"
 #include "pyjit-label.h"
@@ -273,6 +277,11 @@ if (PyModule_AddIntConstant(module, #prefix"_"#name,    \
 
     REGISTER_CONSTANT(INVALID, NAME);
 
+    /* Register CALL_ constants. */
+    REGISTER_CONSTANT(CALL, NOTHROW);
+    REGISTER_CONSTANT(CALL, NORETURN);
+    REGISTER_CONSTANT(CALL, TAIL);
+
     /* Register TYPE_ constants. */
     REGISTER_CONSTANT(TYPE, INVALID);
     REGISTER_CONSTANT(TYPE, VOID);
@@ -339,6 +348,22 @@ if (PyModule_AddIntConstant(module, #prefix"_"#name,    \
     REGISTER_CONSTANT(READELF, WRONG_ARCH);
     REGISTER_CONSTANT(READELF, BAD_FORMAT);
     REGISTER_CONSTANT(READELF, MEMORY);
+    REGISTER_CONSTANT(READELF, FLAG_FORCE);
+    REGISTER_CONSTANT(READELF, FLAG_DEBUG);
+
+    /* Register RESULT_ constants. */
+    REGISTER_CONSTANT(RESULT, OK);
+    REGISTER_CONSTANT(RESULT, OVERFLOW);
+    REGISTER_CONSTANT(RESULT, ARITHMETIC);
+    REGISTER_CONSTANT(RESULT, DIVISION_BY_ZERO);
+    REGISTER_CONSTANT(RESULT, COMPILE_ERROR);
+    REGISTER_CONSTANT(RESULT, OUT_OF_MEMORY);
+    REGISTER_CONSTANT(RESULT, NULL_REFERENCE);
+    REGISTER_CONSTANT(RESULT, NULL_FUNCTION);
+    REGISTER_CONSTANT(RESULT, CALLED_NESTED);
+    REGISTER_CONSTANT(RESULT, OUT_OF_BOUNDS);
+    REGISTER_CONSTANT(RESULT, UNDEFINED_LABEL);
+    REGISTER_CONSTANT(RESULT, MEMORY_FULL);
 
     /* Register OPTION_ constants. */
     REGISTER_CONSTANT(OPTION, CACHE_LIMIT);
@@ -356,7 +381,11 @@ if (pyjit_##name##_init(module) < 0)    \
     return;                             \
 
     INIT_COMPONENT(abi);
+    INIT_COMPONENT(array);
+    INIT_COMPONENT(block);
     INIT_COMPONENT(context);
+    INIT_COMPONENT(elf);
+    INIT_COMPONENT(except);
     INIT_COMPONENT(function);
     INIT_COMPONENT(insn);
     INIT_COMPONENT(label);
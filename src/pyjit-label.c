@@ -27,26 +27,28 @@ label_dealloc(PyJitLabel *self)
     if (self->weakreflist)
         PyObject_ClearWeakRefs((PyObject *)self);
 
-    if (self->label) {
+    /* Several functions may use the same label number, so the cache entry
+     * for our number may belong to another wrapper. Looking it up drops the
+     * entry if it refers to this (now dead) wrapper and keeps it otherwise.
+     */
+    if (self->label != jit_label_undefined) {
         PYJIT_BEGIN_ALLOW_EXCEPTION
-        if (pyjit_weak_cache_delitem(label_cache, (long)self->label) < 0) {
-            PYJIT_TRACE("this shouldn't have happened");
-            abort();
-        }
+        Py_XDECREF(pyjit_weak_cache_getitem(label_cache, (long)self->label));
+        PyErr_Clear();
         PYJIT_END_ALLOW_EXCEPTION
     }
 
     Py_TYPE(self)->tp_free((PyObject *)self);
 }
 
-static int
-_label_verify(PyJitLabel *self)
+static long
+label_hash(PyJitLabel *self)
 {
-    return 0;
+    if (self->label == jit_label_undefined)
+        return _Py_HashPointer(self);
+    return (long)self->label;
 }
 
-PYJIT_HASH_GENERIC(label_hash, PyJitLabel, _label_verify, label)
-
 static int
 label_init(PyJitLabel *self, PyObject *args, PyObject *kwargs)
 {
@@ -55,11 +57,11 @@ label_init(PyJitLabel *self, PyObject *args, PyObject *kwargs)
     if (!PyArg_ParseTupleAndKeywords(args, kwargs, ":Label", kwlist))
         return -1;
 
+    /* Labels are only cached once LibJIT has assigned them a number, see
+     * pyjit_label_register.
+     */
     self->label = jit_label_undefined;
-
-    /* Cache the label. */
-    return pyjit_weak_cache_setitem(
-        label_cache, (long)self->label, (PyObject *)self);
+    return 0;
 }
 
 static PyTypeObject PyJitLabel_Type = {
@@ -138,7 +140,10 @@ PyJitLabel_New(jit_label_t label)
     object = pyjit_weak_cache_getitem(label_cache, numkey);
     if (!object) {
        PyJitLabel *jit_label = PyObject_New(PyJitLabel, &PyJitLabel_Type);
+       if (!jit_label)
+           return NULL;
        jit_label->label = label;
+       jit_label->weakreflist = NULL;
        object = (PyObject *)jit_label;
        if (pyjit_weak_cache_setitem(label_cache, numkey, object) < 0) {
            Py_DECREF(object);
@@ -159,3 +164,21 @@ PyJitLabel_Cast(PyObject *o)
     return NULL;
 }
 
+/* Add a label to the cache after LibJIT assigned it a number, e.g. by placing
+ * it or branching to it. Existing live entries for the same number are kept.
+ */
+int
+pyjit_label_register(PyJitLabel *label)
+{
+    PyObject *o;
+
+    if (label->label == jit_label_undefined)
+        return 0;
+    o = pyjit_weak_cache_getitem(label_cache, (long)label->label);
+    if (o) {
+        Py_DECREF(o);
+        return 0;
+    }
+    return pyjit_weak_cache_setitem(label_cache, (long)label->label,
+                                    (PyObject *)label);
+}
@@ -28,6 +28,7 @@ int pyjit_label_init(PyObject *module);
 const PyTypeObject *pyjit_label_get_pytype(void);
 PyObject *PyJitLabel_New(jit_label_t label);
 PyJitLabel *PyJitLabel_Cast(PyObject *o);
+int pyjit_label_register(PyJitLabel *label);
 
 #endif /* ___PYJIT_LABEL_H__ */
 
@@ -15,6 +15,8 @@
 
 #include "pyjit-marshal.h"
 
+#include "pyjit-array.h"
+
 const char *
 _kind_name(int kind)
 {
@@ -74,41 +76,407 @@ _marshaling_type_error(const char *type, PyObject *o)
     return -1;
 }
 
+/* Storage for pointer arguments. LibJIT reads the argument from the start of
+ * the block, so `pointer' must come first. If the pointer refers to the memory
+ * of a buffer-protocol object, the buffer is held in `view' until the argument
+ * list is freed after the call.
+ */
+typedef struct {
+    void *pointer;
+    Py_buffer view;
+} pointer_arg;
+
 static int
-_marshal_arg_from_py(PyObject *o, jit_type_t type, void **out_arg)
+_marshal_integer_from_py(PyObject *o, jit_type_t type, int is_signed,
+                         void *arg)
 {
-    unsigned long size;
-    void *arg;
+    PyObject *number;
+    unsigned int bits = 8 * (unsigned int)jit_type_get_size(type);
+    int overflow;
+
+    if (!PyInt_Check(o) && !PyLong_Check(o))
+        return _marshaling_type_error(PyInt_Type.tp_name, o);
+    number = PyNumber_Long(o);
+    if (!number)
+        return -1;
+
+    if (is_signed) {
+        PY_LONG_LONG value = PyLong_AsLongLong(number);
+        Py_DECREF(number);
+        if (value == -1 && PyErr_Occurred())
+            return -1;
+        overflow = bits < 64 && (value < -((PY_LONG_LONG)1 << (bits - 1)) ||
+                                 value >= ((PY_LONG_LONG)1 << (bits - 1)));
+        switch (bits) {
+        case 8:
+            *(jit_sbyte *)arg = (jit_sbyte)value;
+            break;
+        case 16:
+            *(jit_short *)arg = (jit_short)value;
+            break;
+        case 32:
+            *(jit_int *)arg = (jit_int)value;
+            break;
+        default:
+            *(jit_long *)arg = (jit_long)value;
+            break;
+        }
+    }
+    else {
+        unsigned PY_LONG_LONG value = PyLong_AsUnsignedLongLong(number);
+        Py_DECREF(number);
+        if (value == (unsigned PY_LONG_LONG)-1 && PyErr_Occurred())
+            return -1;
+        overflow = bits < 64 && (value >> bits) != 0;
+        switch (bits) {
+        case 8:
+            *(jit_ubyte *)arg = (jit_ubyte)value;
+            break;
+        case 16:
+            *(jit_ushort *)arg = (jit_ushort)value;
+            break;
+        case 32:
+            *(jit_uint *)arg = (jit_uint)value;
+            break;
+        default:
+            *(jit_ulong *)arg = (jit_ulong)value;
+            break;
+        }
+    }
+
+    if (overflow) {
+        PyErr_Format(PyExc_OverflowError,
+                     "argument does not fit into %u-bit %s integer", bits,
+                     is_signed ? "signed" : "unsigned");
+        return -1;
+    }
+    return 0;
+}
+
+/* Check that the elements of a buffer match the referent type of a pointer
+ * parameter. Pointers to void accept any buffer.
+ */
+static int
+_marshal_check_buffer_format(Py_buffer *view, jit_type_t ref)
+{
+    const char *format = view->format ? view->format : "B";
+    const char *expected;
+    int kind = jit_type_get_kind(ref);
+
+    if (kind == JIT_TYPE_VOID)
+        return 0;
+
+    if (view->itemsize != (Py_ssize_t)jit_type_get_size(ref)) {
+        PyErr_Format(PyExc_TypeError,
+                     "buffer item size %zd does not match the size %u of "
+                     "the pointer's referent type", view->itemsize,
+                     (unsigned int)jit_type_get_size(ref));
+        return -1;
+    }
+
+    switch (kind) {
+    case JIT_TYPE_SBYTE:
+    case JIT_TYPE_SHORT:
+    case JIT_TYPE_INT:
+    case JIT_TYPE_NINT:
+    case JIT_TYPE_LONG:
+        expected = "bhilq";
+        break;
+    case JIT_TYPE_UBYTE:
+    case JIT_TYPE_USHORT:
+    case JIT_TYPE_UINT:
+    case JIT_TYPE_NUINT:
+    case JIT_TYPE_ULONG:
+        expected = "BHILQc?";
+        break;
+    case JIT_TYPE_FLOAT32:
+    case JIT_TYPE_FLOAT64:
+    case JIT_TYPE_NFLOAT:
+        expected = "fdg";
+        break;
+    default:
+        /* Only the item size can be checked for other referent types. */
+        return 0;
+    }
+
+    /* Skip the byte order mark as long as it denotes native byte order. */
+    switch (*format) {
+    case '@':
+    case '=':
+#ifdef WORDS_BIGENDIAN
+    case '>':
+    case '!':
+#else
+    case '<':
+#endif
+        format++;
+        break;
+    }
+    if (format[0] == '\0' || format[1] != '\0' || !strchr(expected, *format)) {
+        PyErr_Format(PyExc_TypeError,
+                     "buffer format '%.20s' does not match the pointer's "
+                     "referent type", view->format ? view->format : "B");
+        return -1;
+    }
+    return 0;
+}
+
+static int
+_marshal_pointer_from_py(PyObject *o, jit_type_t type, void **out_arg)
+{
+    pointer_arg *arg;
+    PyJitArray *array;
+    jit_type_t ref;
+
+    arg = PyMem_New(pointer_arg, 1);
+    if (!arg) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    arg->view.obj = NULL;
+
+    if (o == Py_None)
+        arg->pointer = NULL;
+    else if (PyInt_Check(o) || PyLong_Check(o)) {
+        /* Raw addresses, e.g. obtained via ctypes.addressof. */
+        arg->pointer = PyLong_AsVoidPtr(o);
+        if (!arg->pointer && PyErr_Occurred())
+            goto error;
+    }
+    else if ((array = PyJitArray_Cast(o)) != NULL) {
+        /* Arrays are passed by their data pointer directly. They outlive the
+         * call since the argument sequence holds a reference to them.
+         */
+        Py_buffer view;
+
+        if (PyJitArray_Verify(array) < 0)
+            goto error;
+        if (array->stride != array->itemsize) {
+            PyErr_SetString(PyExc_ValueError,
+                            "array must be contiguous to be passed as a "
+                            "pointer");
+            goto error;
+        }
+        view.itemsize = array->itemsize;
+        view.format = array->format;
+        ref = jit_type_remove_tags(jit_type_get_ref(type));
+        if (_marshal_check_buffer_format(&view, ref) < 0)
+            goto error;
+        arg->pointer = array->data;
+    }
+    else if (PyObject_CheckBuffer(o)) {
+        /* Hand out writable buffers where possible but fall back to
+         * read-only ones. In either case, the buffer must be contiguous.
+         */
+        if (PyObject_GetBuffer(o, &arg->view,
+                               PyBUF_WRITABLE | PyBUF_FORMAT) < 0) {
+            PyErr_Clear();
+            if (PyObject_GetBuffer(o, &arg->view, PyBUF_FORMAT) < 0) {
+                arg->view.obj = NULL;
+                goto error;
+            }
+        }
+        ref = jit_type_remove_tags(jit_type_get_ref(type));
+        if (_marshal_check_buffer_format(&arg->view, ref) < 0) {
+            PyBuffer_Release(&arg->view);
+            arg->view.obj = NULL;
+            goto error;
+        }
+        arg->pointer = arg->view.buf;
+    }
+    else {
+        _marshaling_type_error("buffer, int or None", o);
+        goto error;
+    }
+
+    *out_arg = arg;
+    return 0;
+
+error:
+    PyMem_Free(arg);
+    return -1;
+}
+
+static int _marshal_into(PyObject *o, jit_type_t type, void *dest);
+
+/* Aggregates are accepted as buffer-protocol objects of the right size (e.g.
+ * ctypes structures or strings), as sequences of field values in declaration
+ * order, or as dicts mapping field names to values. Fields which are not
+ * given are zeroed.
+ */
+static int
+_marshal_aggregate_from_py(PyObject *o, jit_type_t type, void *dest)
+{
+    unsigned int i, num_fields = jit_type_num_fields(type);
+    jit_nuint size = jit_type_get_size(type);
+
+    memset(dest, 0, size);
+
+    if (PyObject_CheckBuffer(o)) {
+        Py_buffer view;
+        int r;
+
+        if (PyObject_GetBuffer(o, &view, PyBUF_SIMPLE) < 0)
+            return -1;
+        r = 0;
+        if (view.len != (Py_ssize_t)size) {
+            PyErr_Format(PyExc_ValueError,
+                         "buffer of %zd bytes cannot be marshaled to an "
+                         "aggregate of %u bytes", view.len,
+                         (unsigned int)size);
+            r = -1;
+        }
+        else
+            memcpy(dest, view.buf, size);
+        PyBuffer_Release(&view);
+        return r;
+    }
+
+    if (PyDict_Check(o)) {
+        PyObject *key, *value;
+        Py_ssize_t pos = 0;
+
+        while (PyDict_Next(o, &pos, &key, &value)) {
+            const char *name;
+
+            if (!PyString_Check(key))
+                return _marshaling_type_error(PyString_Type.tp_name, key);
+            name = PyString_AS_STRING(key);
+            i = jit_type_find_name(type, name);
+            if (i == JIT_INVALID_NAME) {
+                PyErr_Format(PyExc_KeyError, "no field named '%.100s'", name);
+                return -1;
+            }
+            if (_marshal_into(value, jit_type_get_field(type, i),
+                              (char *)dest + jit_type_get_offset(type, i)) < 0)
+                return -1;
+        }
+        return 0;
+    }
+
+    if (PyTuple_Check(o) || PyList_Check(o)) {
+        Py_ssize_t length = PySequence_Fast_GET_SIZE(o);
+
+        if (length > (Py_ssize_t)num_fields) {
+            PyErr_Format(PyExc_ValueError,
+                         "expected at most %u field values, got %zd",
+                         num_fields, length);
+            return -1;
+        }
+        for (i = 0; i < (unsigned int)length; i++) {
+            if (_marshal_into(PySequence_Fast_GET_ITEM(o, i),
+                              jit_type_get_field(type, i),
+                              (char *)dest + jit_type_get_offset(type, i)) < 0)
+                return -1;
+        }
+        return 0;
+    }
+
+    return _marshaling_type_error("buffer, dict, tuple or list", o);
+}
+
+/* Marshal `o' into the memory pointed to by `dest' which must be large enough
+ * to hold a value of type `type'.
+ */
+static int
+_marshal_into(PyObject *o, jit_type_t type, void *dest)
+{
+    double value;
     int kind;
 
-    /* This will return 0 for jit_type_void which is fine for `PyMem_Free' as
-     * the function performs NULL checks.
-     */
-    size = jit_type_get_size(type);
-    arg = PyMem_Malloc(size);
+    type = jit_type_remove_tags(type);
     kind = jit_type_get_kind(type);
     switch (kind) {
     case JIT_TYPE_VOID:
-        break;
+        return 0;
 
     case JIT_TYPE_SBYTE:
+    case JIT_TYPE_SHORT:
+    case JIT_TYPE_INT:
+    case JIT_TYPE_NINT:
+    case JIT_TYPE_LONG:
+        return _marshal_integer_from_py(o, type, 1, dest);
+
     case JIT_TYPE_UBYTE:
+    case JIT_TYPE_USHORT:
+    case JIT_TYPE_UINT:
+    case JIT_TYPE_NUINT:
+    case JIT_TYPE_ULONG:
+        return _marshal_integer_from_py(o, type, 0, dest);
 
-    /* TODO: Perform proper range checks. */
-    case JIT_TYPE_INT:
-        if (!PyInt_Check(o))
-            return _marshaling_type_error(PyInt_Type.tp_name, o);
-        *(int *)arg = PyLong_AsLong(o);
-        break;
+    case JIT_TYPE_FLOAT32:
+    case JIT_TYPE_FLOAT64:
+    case JIT_TYPE_NFLOAT:
+        if (!PyFloat_Check(o) && !PyInt_Check(o) && !PyLong_Check(o))
+            return _marshaling_type_error(PyFloat_Type.tp_name, o);
+        value = PyFloat_AsDouble(o);
+        if (value == -1.0 && PyErr_Occurred())
+            return -1;
+        if (kind == JIT_TYPE_FLOAT32)
+            *(jit_float32 *)dest = (jit_float32)value;
+        else if (kind == JIT_TYPE_FLOAT64)
+            *(jit_float64 *)dest = (jit_float64)value;
+        else
+            *(jit_nfloat *)dest = (jit_nfloat)value;
+        return 0;
 
-    default:
-        return _marshaling_error(kind);
+    case JIT_TYPE_STRUCT:
+    case JIT_TYPE_UNION:
+        return _marshal_aggregate_from_py(o, type, dest);
+
+    case JIT_TYPE_PTR:
+        /* Pointers nested in aggregates cannot hold on to buffers, so only
+         * raw addresses are accepted here.
+         */
+        if (o == Py_None) {
+            *(void **)dest = NULL;
+            return 0;
+        }
+        if (!PyInt_Check(o) && !PyLong_Check(o))
+            return _marshaling_type_error("int or None", o);
+        *(void **)dest = PyLong_AsVoidPtr(o);
+        if (!*(void **)dest && PyErr_Occurred())
+            return -1;
+        return 0;
+    }
+
+    return _marshaling_error(kind);
+}
+
+static int
+_marshal_arg_from_py(PyObject *o, jit_type_t type, void **out_arg)
+{
+    unsigned long size;
+    void *arg;
+
+    type = jit_type_remove_tags(type);
+    if (jit_type_get_kind(type) == JIT_TYPE_PTR)
+        return _marshal_pointer_from_py(o, type, out_arg);
+
+    /* This will return 0 for jit_type_void so make sure to allocate at least
+     * one byte to tell allocation failures apart.
+     */
+    size = jit_type_get_size(type);
+    arg = PyMem_Malloc(size ? size : 1);
+    if (!arg) {
+        PyErr_NoMemory();
+        return -1;
     }
 
+    if (_marshal_into(o, type, arg) < 0) {
+        PyMem_Free(arg);
+        return -1;
+    }
     *out_arg = arg;
     return 0;
 }
 
+int
+pyjit_marshal_arg_into(PyObject *o, jit_type_t type, void *dest)
+{
+    return _marshal_into(o, type, dest);
+}
+
 int
 pyjit_marshal_arg_list_from_py(
     PyObject *args, jit_type_t signature, void ***out_args)
@@ -119,8 +487,12 @@ pyjit_marshal_arg_list_from_py(
     *out_args = NULL;
 
     num_params = jit_type_num_params(signature);
-    args_ = PyMem_New(void *, num_params);
-    memset(args, 0, num_params);
+    args_ = PyMem_New(void *, num_params ? num_params : 1);
+    if (!args_) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    memset(args_, 0, num_params * sizeof(void *));
 
     for (i = 0; i < num_params; i++) {
         int r;
@@ -139,7 +511,7 @@ pyjit_marshal_arg_list_from_py(
 
     if (i != num_params) {
         /* Free the arguments allocated so far. */
-        pyjit_marshal_free_arg_list(args_, num_params);
+        pyjit_marshal_free_arg_list(args_, signature);
         return -1;
     }
 
@@ -148,12 +520,21 @@ pyjit_marshal_arg_list_from_py(
 }
 
 void
-pyjit_marshal_free_arg_list(void **args, unsigned int num_params)
+pyjit_marshal_free_arg_list(void **args, jit_type_t signature)
 {
-    unsigned int i;
+    unsigned int i, num_params;
 
-    for (i = 0; i < num_params; i++)
+    num_params = jit_type_num_params(signature);
+    for (i = 0; i < num_params; i++) {
+        jit_type_t type = jit_type_remove_tags(
+            jit_type_get_param(signature, i));
+        if (args[i] && jit_type_get_kind(type) == JIT_TYPE_PTR) {
+            pointer_arg *arg = (pointer_arg *)args[i];
+            if (arg->view.obj)
+                PyBuffer_Release(&arg->view);
+        }
         PyMem_Free(args[i]);
+    }
     PyMem_Free(args);
 }
 
@@ -163,9 +544,7 @@ pyjit_marshal_arg_to_py(jit_type_t type, void *arg)
     PyObject *retval = NULL;
     int kind;
 
-    /* XXX: This probably needs some compile-time tests to marshal all types
-     *      properly.
-     */
+    type = jit_type_remove_tags(type);
     kind = jit_type_get_kind(type);
     switch (kind) {
     case JIT_TYPE_VOID:
@@ -174,36 +553,88 @@ pyjit_marshal_arg_to_py(jit_type_t type, void *arg)
         break;
 
     case JIT_TYPE_SBYTE:
-    case JIT_TYPE_SHORT:
-    case JIT_TYPE_INT:
-        retval = PyInt_FromLong(*(int *)arg);
+        retval = PyInt_FromLong(*(jit_sbyte *)arg);
         break;
 
     case JIT_TYPE_UBYTE:
+        retval = PyInt_FromLong(*(jit_ubyte *)arg);
+        break;
+
+    case JIT_TYPE_SHORT:
+        retval = PyInt_FromLong(*(jit_short *)arg);
+        break;
+
     case JIT_TYPE_USHORT:
+        retval = PyInt_FromLong(*(jit_ushort *)arg);
+        break;
+
+    case JIT_TYPE_INT:
+        retval = PyInt_FromLong(*(jit_int *)arg);
+        break;
+
     case JIT_TYPE_UINT:
-        retval = PyInt_FromSize_t(*(unsigned int *)arg);
+        retval = PyInt_FromSize_t(*(jit_uint *)arg);
         break;
 
     case JIT_TYPE_NINT:
-    case JIT_TYPE_LONG:
-        retval = PyLong_FromLong(*(long *)arg);
+        retval = PyInt_FromSsize_t(*(jit_nint *)arg);
         break;
 
     case JIT_TYPE_NUINT:
+        retval = PyInt_FromSize_t(*(jit_nuint *)arg);
+        break;
+
+    case JIT_TYPE_LONG:
+        retval = PyLong_FromLongLong(*(jit_long *)arg);
+        break;
+
     case JIT_TYPE_ULONG:
-        retval = PyLong_FromUnsignedLong(*(unsigned long *)arg);
+        retval = PyLong_FromUnsignedLongLong(*(jit_ulong *)arg);
         break;
 
     case JIT_TYPE_FLOAT32:
+        retval = PyFloat_FromDouble(*(jit_float32 *)arg);
+        break;
+
     case JIT_TYPE_FLOAT64:
-        retval = PyFloat_FromDouble(*(double *)arg);
+        retval = PyFloat_FromDouble(*(jit_float64 *)arg);
         break;
 
+    case JIT_TYPE_NFLOAT:
+        retval = PyFloat_FromDouble((double)*(jit_nfloat *)arg);
+        break;
+
+    case JIT_TYPE_PTR:
+        retval = PyLong_FromVoidPtr(*(void **)arg);
+        break;
+
+    case JIT_TYPE_STRUCT:
+    case JIT_TYPE_UNION:
+    {
+        /* Aggregates are returned as tuples of their field values. For
+         * unions, this yields every interpretation of the stored value.
+         */
+        unsigned int i, num_fields = jit_type_num_fields(type);
+
+        retval = PyTuple_New(num_fields);
+        if (!retval)
+            break;
+        for (i = 0; i < num_fields; i++) {
+            PyObject *item = pyjit_marshal_arg_to_py(
+                jit_type_get_field(type, i),
+                (char *)arg + jit_type_get_offset(type, i));
+            if (!item) {
+                Py_CLEAR(retval);
+                break;
+            }
+            PyTuple_SET_ITEM(retval, i, item);
+        }
+        break;
+    }
+
     default:
         _marshaling_error(kind);
         break;
     }
     return retval;
 }
-
@@ -20,7 +20,8 @@
 
 int pyjit_marshal_arg_list_from_py(
     PyObject *args, jit_type_t signature, void ***out_args);
-void pyjit_marshal_free_arg_list(void **args, unsigned int num_params);
+void pyjit_marshal_free_arg_list(void **args, jit_type_t signature);
+int pyjit_marshal_arg_into(PyObject *o, jit_type_t type, void *dest);
 PyObject *pyjit_marshal_arg_to_py(jit_type_t type, void *arg);
 
 #endif /* __PYJIT_MARSHAL_H__ */
@@ -49,6 +49,12 @@ PYJIT_REPR_GENERIC(value_repr, PyJitValue, value)
 
 PYJIT_HASH_GENERIC(value_hash, PyJitValue, PyJitValue_Verify, value)
 
+static jit_value_t _value_create_constant(jit_function_t function,
+                                          PyObject *o);
+
+/* Comparisons emit the corresponding comparison instruction. As with the
+ * number protocol, Python numbers are converted to constants first.
+ */
 static PyObject *
 value_richcompare(PyJitValue *self, PyObject *other, int opid)
 {
@@ -57,6 +63,7 @@ value_richcompare(PyJitValue *self, PyObject *other, int opid)
     jit_function_t function;
     jit_value_t (*cmpfunc)(jit_function_t, jit_value_t, jit_value_t) = NULL;
     jit_value_t value;
+    PyObject *r;
 
     if (PyJitValue_Verify(self) < 0)
         return NULL;
@@ -65,6 +72,20 @@ value_richcompare(PyJitValue *self, PyObject *other, int opid)
         return NULL;
     function = jit_function->function;
 
+    if (PyInt_Check(other) || PyLong_Check(other) || PyFloat_Check(other)) {
+        PyObject *constant;
+
+        value = _value_create_constant(function, other);
+        if (!value)
+            return NULL;
+        constant = PyJitValue_New(value, self->function);
+        if (!constant)
+            return NULL;
+        r = value_richcompare(self, constant, opid);
+        Py_DECREF(constant);
+        return r;
+    }
+
     jit_other = PyJitValue_CastAndVerify(other);
     if (!jit_other)
         return NULL;
@@ -129,7 +150,9 @@ _value_create_constant(jit_function_t function, PyObject *o)
             function, jit_type_nint, value);
     }
     else if (PyLong_Check(o)) {
-        jit_long value = PyLong_AsLong(o);
+        jit_long value = PyLong_AsLongLong(o);
+        if (value == -1 && PyErr_Occurred())
+            return NULL;
         retval = jit_value_create_long_constant(
             function, jit_type_long, value);
     }
@@ -308,6 +331,47 @@ value_create_nint_constant(void *null, PyObject *args, PyObject *kwargs)
     return PyJitValue_New(value, func);
 }
 
+/* 64-bit constants accept the full range of both jit.Type.LONG and
+ * jit.Type.ULONG. Values beyond the signed range are stored as their two's
+ * complement bit pattern.
+ */
+static PyObject *
+value_create_long_constant(void *null, PyObject *args, PyObject *kwargs)
+{
+    PyObject *func = NULL, *type = NULL, *py_value = NULL;
+    jit_long const_value;
+    jit_value_t value;
+    static char *kwlist[] = { "func", "type_", "const_value", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO:Value", kwlist, &func,
+                                     &type, &py_value))
+        return NULL;
+
+    if (check_func_and_type(func, type) < 0)
+        return NULL;
+
+    if (!PyInt_Check(py_value) && !PyLong_Check(py_value)) {
+        PyErr_Format(PyExc_TypeError,
+                     "const_value must be an integer, not %.100s",
+                     Py_TYPE(py_value)->tp_name);
+        return NULL;
+    }
+    const_value = PyLong_AsLongLong(py_value);
+    if (const_value == -1 && PyErr_Occurred()) {
+        if (!PyErr_ExceptionMatches(PyExc_OverflowError))
+            return NULL;
+        PyErr_Clear();
+        const_value = (jit_long)PyLong_AsUnsignedLongLong(py_value);
+        if (const_value == -1 && PyErr_Occurred())
+            return NULL;
+    }
+
+    value = jit_value_create_long_constant(
+        ((PyJitFunction *)func)->function, ((PyJitType *)type)->type,
+        const_value);
+    return PyJitValue_New(value, func);
+}
+
 static PyObject *
 value_create_float32_constant(void *null, PyObject *args, PyObject *kwargs)
 {
@@ -333,11 +397,11 @@ static PyObject *
 value_create_float64_constant(void *null, PyObject *args, PyObject *kwargs)
 {
     PyObject *func = NULL, *type = NULL;
-    jit_float32 const_value;
+    jit_float64 const_value;
     jit_value_t value;
     static char *kwlist[] = { "func", "type_", "const_value", NULL };
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOf:Value", kwlist, &func,
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOd:Value", kwlist, &func,
                                      &type, &const_value))
         return NULL;
 
@@ -496,7 +560,7 @@ value_get_nint_constant(PyJitValue *self)
 static PyObject *
 value_get_long_constant(PyJitValue *self)
 {
-    return PyLong_FromLong(jit_value_get_long_constant(self->value));
+    return PyLong_FromLongLong(jit_value_get_long_constant(self->value));
 }
 
 static PyObject *
@@ -515,15 +579,124 @@ DEFINE_BOOLEAN_METHOD(is_true)
 
 #undef DEFINE_BOOLEAN_METHOD
 
+/* Field access through struct pointers
+ *
+ * The offset of the field is looked up while building the function, so the
+ * emitted code consists of a single relative load or store with a constant
+ * offset.
+ */
+static int
+_value_resolve_field(PyJitValue *self, const char *name,
+                     jit_function_t *function, jit_nuint *offset,
+                     jit_type_t *field_type)
+{
+    PyJitFunction *jit_function;
+    jit_type_t type;
+    unsigned int index;
+
+    jit_function = PyJitFunction_CastAndVerify(self->function);
+    if (!jit_function)
+        return -1;
+    *function = jit_function->function;
+
+    type = jit_type_remove_tags(jit_value_get_type(self->value));
+    if (!jit_type_is_pointer(type)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "value must be a pointer to a struct or union");
+        return -1;
+    }
+    type = jit_type_remove_tags(jit_type_get_ref(type));
+    if (!jit_type_is_struct(type) && !jit_type_is_union(type)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "value must be a pointer to a struct or union");
+        return -1;
+    }
+
+    index = jit_type_find_name(type, name);
+    if (index == JIT_INVALID_NAME) {
+        PyErr_Format(PyExc_AttributeError, "no field named '%.100s'", name);
+        return -1;
+    }
+    *offset = jit_type_get_offset(type, index);
+    *field_type = jit_type_get_field(type, index);
+    return 0;
+}
+
+static PyObject *
+value_field(PyJitValue *self, PyObject *args, PyObject *kwargs)
+{
+    const char *name;
+    jit_function_t function;
+    jit_nuint offset;
+    jit_type_t field_type;
+    static char *kwlist[] = { "name", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s:Value", kwlist, &name))
+        return NULL;
+
+    if (_value_resolve_field(self, name, &function, &offset, &field_type) < 0)
+        return NULL;
+
+    return PyJitValue_New(
+        jit_insn_load_relative(function, self->value, (jit_nint)offset,
+                               field_type),
+        self->function);
+}
+
+static PyObject *
+value_set_field(PyJitValue *self, PyObject *args, PyObject *kwargs)
+{
+    const char *name;
+    PyObject *value = NULL;
+    PyJitValue *jit_value;
+    jit_function_t function;
+    jit_nuint offset;
+    jit_type_t field_type;
+    jit_value_t field_value;
+    static char *kwlist[] = { "name", "value", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO:Value", kwlist, &name,
+                                     &value))
+        return NULL;
+
+    if (_value_resolve_field(self, name, &function, &offset, &field_type) < 0)
+        return NULL;
+
+    jit_value = PyJitValue_Cast(value);
+    if (jit_value)
+        field_value = jit_value->value;
+    else {
+        field_value = _value_create_constant(function, value);
+        if (!field_value) {
+            if (!PyErr_Occurred()) {
+                PyErr_SetString(PyExc_MemoryError,
+                                "memory allocation inside LibJIT failed");
+            }
+            return NULL;
+        }
+    }
+
+    /* A relative store writes as many bytes as the stored value occupies, so
+     * convert the value to the type of the field first.
+     */
+    field_value = jit_insn_convert(function, field_value, field_type, 0);
+    if (!field_value) {
+        PyErr_SetString(PyExc_MemoryError,
+                        "memory allocation inside LibJIT failed");
+        return NULL;
+    }
+    return PyBool_FromLong(
+        jit_insn_store_relative(function, self->value, (jit_nint)offset,
+                                field_value));
+}
+
 static PyMethodDef value_methods[] = {
     /* XXX: Implementing the functionality of `create' in the constructor of
      *      jit.Value would make more sense (see jit.Function).
      */
     PYJIT_STATIC_METHOD_KW(value, create),
     PYJIT_STATIC_METHOD_KW(value, create_nint_constant),
-    /* XXX: long and jit_nint might not always be identical. */
-    PYJIT_METHOD_EX("create_long_constant", value_create_nint_constant,
-                    METH_STATIC | METH_KEYWORDS),
+    PYJIT_STATIC_METHOD_KW(value, create_long_constant),
     PYJIT_STATIC_METHOD_KW(value, create_float32_constant),
     PYJIT_STATIC_METHOD_KW(value, create_float64_constant),
     /* XXX: Python doesn't support long doubles */
@@ -556,6 +729,8 @@ static PyMethodDef value_methods[] = {
     /* XXX: See above. */
     /* jit_value_get_nfloat_constant */
     PYJIT_METHOD_NOARGS(value, is_true),
+    PYJIT_METHOD_KW(value, field),
+    PYJIT_METHOD_KW(value, set_field),
     { NULL } /* Sentinel */
 };
 
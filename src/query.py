@@ -0,0 +1,433 @@
+# python-libjit, Copyright 2014 Niklas Koep
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Compiled filters and aggregations over columnar data.
+
+Predicates are written as expression trees over named columns, e.g.
+
+    (col("price") > 10.0) & ~(col("qty") == 0)
+
+and compiled into functions which write the indices of all matching rows to
+a selection vector. Rows can then be grouped by integer keys with compiled
+hash aggregations.
+"""
+
+import operator
+
+from _jit import ABI_CDECL, Array, Context, Function, Insn, Label, Type, Value
+from kernels import (_FLOAT_TYPES, _INTEGER_LIMITS, _constant, _identity,
+                     _local_copy, _resolve_dtype)
+
+class Expr(object):
+    """Node of a predicate expression tree.
+
+    Arithmetic, comparison and the bitwise operators &, | and ~ build new
+    nodes. Since Python's `and', `or' and `not' cannot be overloaded, the
+    bitwise operators serve as logical connectives. Both operands of & and |
+    are always evaluated, which keeps the compiled filter free of branches.
+    """
+
+    def _emit(self, function, columns):
+        raise NotImplementedError
+
+    def names(self):
+        """Return the set of column names referenced by the expression."""
+        return set()
+
+    def __lt__(self, other):
+        return BinaryOp(operator.lt, self, other)
+
+    def __le__(self, other):
+        return BinaryOp(operator.le, self, other)
+
+    def __eq__(self, other):
+        return BinaryOp(operator.eq, self, other)
+
+    def __ne__(self, other):
+        return BinaryOp(operator.ne, self, other)
+
+    def __gt__(self, other):
+        return BinaryOp(operator.gt, self, other)
+
+    def __ge__(self, other):
+        return BinaryOp(operator.ge, self, other)
+
+    __hash__ = object.__hash__
+
+    def __add__(self, other):
+        return BinaryOp(operator.add, self, other)
+
+    def __radd__(self, other):
+        return BinaryOp(operator.add, other, self)
+
+    def __sub__(self, other):
+        return BinaryOp(operator.sub, self, other)
+
+    def __rsub__(self, other):
+        return BinaryOp(operator.sub, other, self)
+
+    def __mul__(self, other):
+        return BinaryOp(operator.mul, self, other)
+
+    def __rmul__(self, other):
+        return BinaryOp(operator.mul, other, self)
+
+    def __div__(self, other):
+        return BinaryOp(operator.div, self, other)
+
+    def __rdiv__(self, other):
+        return BinaryOp(operator.div, other, self)
+
+    def __mod__(self, other):
+        return BinaryOp(operator.mod, self, other)
+
+    def __rmod__(self, other):
+        return BinaryOp(operator.mod, other, self)
+
+    def __neg__(self):
+        return UnaryOp(Insn.neg, self)
+
+    def __and__(self, other):
+        return BinaryOp(_logical_and, self, other)
+
+    def __rand__(self, other):
+        return BinaryOp(_logical_and, other, self)
+
+    def __or__(self, other):
+        return BinaryOp(_logical_or, self, other)
+
+    def __ror__(self, other):
+        return BinaryOp(_logical_or, other, self)
+
+    def __invert__(self):
+        return UnaryOp(Insn.to_not_bool, self)
+
+    def isin(self, values):
+        """Return an expression which is true if the value equals any of
+        `values'.
+        """
+        values = list(values)
+        if not values:
+            raise ValueError("values must not be empty")
+        return reduce(operator.or_, [self == value for value in values])
+
+class Column(Expr):
+    def __init__(self, name):
+        self.name = name
+
+    def _emit(self, function, columns):
+        return columns[self.name]
+
+    def names(self):
+        return set([self.name])
+
+    def __repr__(self):
+        return "col(%r)" % self.name
+
+class BinaryOp(Expr):
+    def __init__(self, op, lhs, rhs):
+        self.op = op
+        self.lhs = lhs
+        self.rhs = rhs
+
+    def _emit(self, function, columns):
+        return self.op(_emit(self.lhs, function, columns),
+                       _emit(self.rhs, function, columns))
+
+    def names(self):
+        return _names(self.lhs) | _names(self.rhs)
+
+class UnaryOp(Expr):
+    def __init__(self, op, operand):
+        self.op = op
+        self.operand = operand
+
+    def _emit(self, function, columns):
+        value = _emit(self.operand, function, columns)
+        if not isinstance(value, Value):
+            value = _constant(function, Type.NINT, value)
+        return self.op(function, value)
+
+    def names(self):
+        return _names(self.operand)
+
+def col(name):
+    """Return an expression referring to the column `name'."""
+    return Column(name)
+
+def _emit(node, function, columns):
+    if isinstance(node, Expr):
+        return node._emit(function, columns)
+    if isinstance(node, (bool, int, long, float)):
+        return node
+    raise TypeError("cannot use %r in a filter expression" % (node,))
+
+def _names(node):
+    return node.names() if isinstance(node, Expr) else set()
+
+def _truth(value):
+    return Insn.to_bool(value.get_function(), value)
+
+def _logical_and(a, b):
+    if not isinstance(a, Value) and not isinstance(b, Value):
+        return bool(a) and bool(b)
+    return _truth(_as_value(a, b)) & _truth(_as_value(b, a))
+
+def _logical_or(a, b):
+    if not isinstance(a, Value) and not isinstance(b, Value):
+        return bool(a) or bool(b)
+    return _truth(_as_value(a, b)) | _truth(_as_value(b, a))
+
+def _as_value(value, other):
+    """Convert `value' to a constant in the function of the jit.Value
+    `other' unless it is a jit.Value itself.
+    """
+    if isinstance(value, Value):
+        return value
+    return _constant(other.get_function(), Type.NINT, int(bool(value)))
+
+def _column_list(columns):
+    if hasattr(columns, "items"):
+        return sorted(columns.items())
+    return list(columns)
+
+def compile_filter(expr, columns, context=None, index_dtype="uint32"):
+    """Compile a filter selecting the rows for which `expr' is true.
+
+    `columns' maps column names to jit.Types or keys of jit.kernels.DTYPES,
+    either as a dict or as a sequence of (name, dtype) pairs. The returned
+    jit.Function takes one pointer per column (in the order of the sequence,
+    or sorted by name for dicts), a pointer to the selection vector and the
+    number of rows. It writes the indices of the matching rows, in ascending
+    order and of type `index_dtype', to the selection vector, which must have
+    room for one index per row, and returns the number of matching rows as a
+    jit.Type.NINT. If `context' is None, a new jit.Context is created.
+    """
+    if not isinstance(expr, Expr):
+        raise TypeError("expr must be a filter expression")
+    columns = [(name, _resolve_dtype(dtype))
+               for name, dtype in _column_list(columns)]
+    names = [name for name, _ in columns]
+    if len(set(names)) != len(names):
+        raise ValueError("column names must be unique")
+    unknown = expr.names() - set(names)
+    if unknown:
+        raise ValueError("unknown columns: %s" % ", ".join(sorted(unknown)))
+    index_type = _resolve_dtype(index_dtype)
+
+    params = ([type_.create_pointer() for _, type_ in columns] +
+              [index_type.create_pointer(), Type.NINT])
+    signature = Type.create_signature(ABI_CDECL, Type.NINT, params)
+    referenced = expr.names()
+
+    if context is None:
+        context = Context()
+    function = Function(context, signature)
+    pointers = [function.value_get_param(i) for i in range(len(columns))]
+    selection = function.value_get_param(len(columns))
+    count = function.value_get_param(len(columns) + 1)
+    num_selected = _local_copy(function, _constant(function, Type.NINT, 0))
+
+    @function.loop(0, count)
+    def body(i):
+        values = {}
+        for (name, type_), pointer in zip(columns, pointers):
+            if name in referenced:
+                values[name] = Insn.load_elem(function, pointer, i, type_)
+        result = _emit(expr, function, values)
+        if not isinstance(result, Value):
+            result = _constant(function, Type.NINT, int(bool(result)))
+
+        # Store the index unconditionally and only advance the output
+        # position for matches so that the loop body has no branches.
+        Insn.store_elem(function, selection, num_selected,
+                        Insn.convert(function, i, index_type, False))
+        Insn.store(function, num_selected,
+                   num_selected + _truth(result))
+
+    function.insn_return(num_selected)
+
+    function.compile_()
+    return function
+
+_AGGREGATES = ("sum", "count", "min", "max")
+
+# Multiplier of Fibonacci hashing, i.e. 2 ** 64 divided by the golden ratio,
+# given as a signed 64-bit integer.
+_HASH_MULTIPLIER = 0x9e3779b97f4a7c15 - 2 ** 64
+
+def _accumulator_type(op, type_):
+    if op == "count":
+        return Type.NINT
+    if op != "sum":
+        return type_
+    if type_ in _FLOAT_TYPES:
+        return Type.FLOAT64
+    return Type.ULONG if _INTEGER_LIMITS[type_][1] == -1 else Type.LONG
+
+class HashAggregate(object):
+    """Compiled group-by over integer keys using an open-addressing table.
+
+    `function' takes a pointer to the key column, one pointer per value
+    column (one for each aggregate except "count"), a pointer to the table,
+    the number of slots in the table and the number of rows. It returns the
+    number of rows aggregated, which is less than the number of rows if the
+    table ran full. Tables are arrays of `slot_type' whose number of slots is a
+    power of two and which are zeroed before first use. new_table creates
+    such tables.
+    """
+
+    def __init__(self, function, slot_type, aggregates):
+        self.function = function
+        self.slot_type = slot_type
+        self.aggregates = aggregates
+
+    def new_table(self, capacity):
+        """Return an empty table with `capacity' slots."""
+        if capacity < 1 or capacity & (capacity - 1):
+            raise ValueError("capacity must be a positive power of two")
+        return Array(self.slot_type, capacity)
+
+    def __call__(self, keys, values, table, count):
+        """Aggregate `count' rows of the `keys' column and the columns in
+        `values' into `table'. Returns the number of rows aggregated.
+        """
+        return self.function.apply_(
+            [keys] + list(values) + [table, len(table), count])
+
+    def groups(self, table):
+        """Return a dict mapping the keys in `table' to tuples of their
+        aggregates.
+        """
+        return dict((slot[0], slot[2:]) for slot in table if slot[1])
+
+def compile_hash_aggregate(key_dtype, aggregates, context=None):
+    """Compile a HashAggregate grouping by keys of type `key_dtype'.
+
+    `aggregates' is a sequence of ops, each either "count" or a pair of an op
+    out of "sum", "min" and "max" and the dtype of the column it aggregates.
+    Sums are accumulated as 64-bit integers or as jit.Type.FLOAT64 and
+    counts as jit.Type.NINT. If `context' is None, a new jit.Context is
+    created.
+    """
+    key_type = _resolve_dtype(key_dtype)
+    if key_type not in _INTEGER_LIMITS:
+        raise TypeError("keys must be integers")
+
+    ops = []
+    for aggregate in aggregates:
+        if aggregate == "count":
+            ops.append(("count", None, Type.NINT))
+            continue
+        op, dtype = aggregate
+        if op not in _AGGREGATES or op == "count":
+            raise ValueError("unknown aggregate '%s'" % op)
+        type_ = _resolve_dtype(dtype)
+        if type_ not in _INTEGER_LIMITS and type_ not in _FLOAT_TYPES:
+            raise TypeError("cannot aggregate values of type '%s'" % type_)
+        ops.append((op, type_, _accumulator_type(op, type_)))
+
+    slot_type = Type.create_struct(
+        [key_type, Type.UBYTE] + [acc_type for _, _, acc_type in ops])
+    slot_type.set_names(["key", "used"] + ["%s%d" % (op, i)
+                                          for i, (op, _, _) in enumerate(ops)])
+    slot_size = slot_type.get_size()
+    key_offset = slot_type.get_offset(0)
+    used_offset = slot_type.get_offset(1)
+    offsets = [slot_type.get_offset(i + 2) for i in range(len(ops))]
+    num_columns = len([op for op, _, _ in ops if op != "count"])
+
+    params = ([key_type.create_pointer()] +
+              [type_.create_pointer() for op, type_, _ in ops
+               if op != "count"] +
+              [slot_type.create_pointer(), Type.NINT, Type.NINT])
+    signature = Type.create_signature(ABI_CDECL, Type.NINT, params)
+
+    if context is None:
+        context = Context()
+    function = Function(context, signature)
+    keys = function.value_get_param(0)
+    columns = [function.value_get_param(i + 1)
+               for i in range(num_columns)]
+    table = function.value_get_param(num_columns + 1)
+    capacity = function.value_get_param(num_columns + 2)
+    count = function.value_get_param(num_columns + 3)
+    mask = _local_copy(function, capacity - 1)
+    index = Value.create(function, Type.NINT)
+    probes = Value.create(function, Type.NINT)
+
+    @function.loop(0, count)
+    def body(i):
+        probe, empty, found = Label(), Label(), Label()
+        key = Insn.load_elem(function, keys, i, key_type)
+
+        # Fibonacci hashing, folding the high bits into the low ones
+        # which select the slot.
+        h = Insn.convert(function, key, Type.ULONG, False)
+        h = h * _constant(function, Type.ULONG, _HASH_MULTIPLIER)
+        h = h ^ Insn.ushr(function, h, _constant(function, Type.ULONG, 32))
+        Insn.store(function, index,
+                   Insn.convert(function, h, Type.NINT, False) & mask)
+        Insn.store(function, probes, _constant(function, Type.NINT, 0))
+
+        # Linear probing until the key or an empty slot is found. If
+        # every slot has been probed, the table is full.
+        Insn.label(function, probe)
+        slot = _local_copy(function, table + index * slot_size)
+        Insn.branch_if_not(
+            function,
+            Insn.load_relative(function, slot, used_offset, Type.UBYTE),
+            empty)
+        Insn.branch_if(
+            function,
+            Insn.load_relative(function, slot, key_offset, key_type) ==
+            key,
+            found)
+        Insn.store(function, index, (index + 1) & mask)
+        Insn.store(function, probes, probes + 1)
+        Insn.branch_if(function, probes < capacity, probe)
+        function.insn_return(i)
+
+        Insn.label(function, empty)
+        Insn.store_relative(function, slot, used_offset,
+                            _constant(function, Type.UBYTE, 1))
+        Insn.store_relative(function, slot, key_offset, key)
+        for (op, type_, acc_type), offset in zip(ops, offsets):
+            Insn.store_relative(
+                function, slot, offset, _constant(
+                    function, acc_type,
+                    _identity("sum" if op == "count" else op, type_)))
+
+        Insn.label(function, found)
+        column = 0
+        for (op, type_, acc_type), offset in zip(ops, offsets):
+            acc = Insn.load_relative(function, slot, offset, acc_type)
+            if op == "count":
+                acc = acc + 1
+            else:
+                value = Insn.convert(function, Insn.load_elem(
+                    function, columns[column], i, type_), acc_type, False)
+                column += 1
+                if op == "sum":
+                    acc = acc + value
+                else:
+                    acc = getattr(Insn, op)(function, acc, value)
+            Insn.store_relative(
+                function, slot, offset,
+                Insn.convert(function, acc, acc_type, False))
+
+    function.insn_return(count)
+
+    function.compile_()
+    return HashAggregate(function, slot_type, tuple(ops))
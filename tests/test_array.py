@@ -0,0 +1,86 @@
+import unittest
+import ctypes
+
+import jit
+
+class TestArray(unittest.TestCase):
+    def setUp(self):
+        self.array = jit.Array(jit.Type.INT, 10)
+
+    def test_construction(self):
+        self.assertEqual(len(self.array), 10)
+        self.assertEqual(list(self.array), [0] * 10)
+        self.assertIs(self.array.get_type(), jit.Type.INT)
+        with self.assertRaises(TypeError):
+            jit.Array(1, 10)
+        with self.assertRaises(ValueError):
+            jit.Array(jit.Type.INT, -1)
+        with self.assertRaises(ValueError):
+            jit.Array(jit.Type.INT, 10, alignment=48)
+        with self.assertRaises(ValueError):
+            jit.Array(jit.Type.VOID, 10)
+
+    def test_alignment(self):
+        for alignment in (1, 16, 64, 4096):
+            array = jit.Array(jit.Type.FLOAT64, 3, alignment=alignment)
+            self.assertEqual(array.get_address() % alignment, 0)
+
+    def test_items(self):
+        self.array[0] = 1
+        self.array[-1] = -2
+        self.assertEqual(self.array[0], 1)
+        self.assertEqual(self.array[9], -2)
+        with self.assertRaises(IndexError):
+            self.array[10]
+        with self.assertRaises(OverflowError):
+            self.array[0] = 2 ** 40
+        with self.assertRaises(TypeError):
+            del self.array[0]
+
+    def test_slicing(self):
+        self.array[:] = range(10)
+        view = self.array[1::2]
+        self.assertEqual(list(view), [1, 3, 5, 7, 9])
+        self.assertFalse(view.is_contiguous())
+        view[:] = [0] * 5
+        self.assertEqual(list(self.array), [0, 0, 2, 0, 4, 0, 6, 0, 8, 0])
+        self.assertEqual(list(self.array[::-3]), [0, 6, 0, 0])
+        self.assertEqual(self.array[2:4].get_address(),
+                         self.array.get_address() + 2 * ctypes.sizeof(
+                             ctypes.c_int))
+        with self.assertRaises(ValueError):
+            self.array[:2] = [1, 2, 3]
+
+    def test_buffer_protocol(self):
+        self.array[:] = range(10)
+        view = memoryview(self.array)
+        self.assertEqual(view.format, "i")
+        self.assertEqual(view.itemsize, ctypes.sizeof(ctypes.c_int))
+        self.assertEqual(view.tobytes(), bytes(buffer(self.array)))
+        c_array = (ctypes.c_int * 10).from_buffer(self.array)
+        c_array[3] = 42
+        self.assertEqual(self.array[3], 42)
+        # Views with a step are exported with strides, which memoryview
+        # requests, but not to consumers expecting contiguous memory.
+        view = memoryview(self.array[::2])
+        self.assertEqual(view.shape, (5,))
+        self.assertEqual(view.strides, (2 * ctypes.sizeof(ctypes.c_int),))
+        with self.assertRaises(BufferError):
+            (ctypes.c_int * 5).from_buffer(self.array[::2])
+
+    def test_pointer_argument(self):
+        signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.INT, [jit.Type.INT.create_pointer()])
+        with jit.Context() as context:
+            function = jit.Function(context, signature)
+            pointer = function.value_get_param(0)
+            function.insn_return(
+                jit.Insn.load_elem(function, pointer, 2, jit.Type.INT))
+
+        self.array[:] = range(10, 20)
+        self.assertEqual(function(self.array), 12)
+        self.assertEqual(function(self.array[3:]), 15)
+        with self.assertRaises(ValueError):
+            function(self.array[::2])
+        with self.assertRaises(TypeError):
+            function(jit.Array(jit.Type.FLOAT32, 4))
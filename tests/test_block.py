@@ -0,0 +1,28 @@
+import unittest
+
+import jit
+
+class TestBlock(unittest.TestCase):
+    def setUp(self):
+        context = jit.Context()
+        signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.INT, [jit.Type.INT, jit.Type.INT])
+        self.function = jit.Function(context, signature)
+
+    def test_block_iteration(self):
+        x = self.function.value_get_param(0)
+        y = self.function.value_get_param(1)
+        self.function.insn_return(x - y)
+        block = jit.Block.next_(self.function)
+        self.assertIsNotNone(block)
+        self.assertEqual(block.get_function(), self.function)
+        # jit.Value overloads comparison operators, so compare identities.
+        insns = [insn for insn in block if insn.get_value1() is x]
+        self.assertEqual(len(insns), 1)
+        self.assertIs(insns[0].get_value2(), y)
+
+    def test_block_next(self):
+        with self.assertRaises(TypeError):
+            jit.Block.next_(0)
+        with self.assertRaises(TypeError):
+            jit.Block.next_(self.function, 0)
@@ -62,3 +62,20 @@ def test_libjit_to_ctypes_conversion(self):
             self.assertEqual(fields[idx][0], "%%%d" % (idx+1))
             self.assertIs(types[idx], types[idx])
 
+
+    def test_conversions_are_cached(self):
+        convertfunc = jit.Closure._convert_libjit_to_ctypes
+        struct = jit.Type.create_struct((jit.Type.INT, jit.Type.FLOAT64))
+        struct.set_names(("count", "total"))
+        pointer = struct.create_pointer()
+        self.assertIs(convertfunc(struct), convertfunc(struct))
+        self.assertIs(convertfunc(pointer)._type_, convertfunc(struct))
+
+        with jit.Context() as context:
+            signature = jit.Type.create_signature(
+                jit.ABI_CDECL, jit.Type.INT, (pointer,))
+            function = jit.Function(context, signature)
+            function.insn_return(function.value_get_param(0).field("count"))
+        closure1 = jit.Closure(function)
+        closure2 = jit.Closure(function)
+        self.assertIs(closure1.argtypes[0], closure2.argtypes[0])
@@ -0,0 +1,48 @@
+import unittest
+import gc
+import weakref
+
+import jit
+
+class TestCodeCache(unittest.TestCase):
+    def setUp(self):
+        self.signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.INT, [jit.Type.INT])
+        self.cache = jit.CodeCache(1 << 20)
+
+    def test_constructor(self):
+        with self.assertRaises(ValueError):
+            jit.CodeCache(0)
+        with self.assertRaises(ValueError):
+            jit.CodeCache(1 << 20, generations=0)
+        self.assertEqual(self.cache.get_context().get_meta_numeric(
+            jit.OPTION_CACHE_LIMIT), 1 << 20)
+
+    def test_rebuild_after_rotation(self):
+        num_builds = []
+        def build(function):
+            num_builds.append(None)
+            function.insn_return(function.value_get_param(0) * 2)
+        double = self.cache.add(self.signature, build)
+        self.assertEqual(len(num_builds), 0)
+        self.assertEqual(double(21), 42)
+        self.assertEqual(double(4), 8)
+        self.assertEqual(len(num_builds), 1)
+        context = weakref.ref(double.get_function().get_context())
+
+        # The first generation survives one rotation.
+        self.cache.rotate()
+        gc.collect()
+        self.assertIsNotNone(context())
+        self.assertEqual(double(1), 2)
+        self.assertEqual(len(num_builds), 1)
+
+        # Dropping the generation destroys its context, and the function is
+        # rebuilt in the current one.
+        self.cache.rotate()
+        gc.collect()
+        self.assertIsNone(context())
+        self.assertEqual(double(5), 10)
+        self.assertEqual(len(num_builds), 2)
+        self.assertIs(double.get_function().get_context(),
+                      self.cache.get_context())
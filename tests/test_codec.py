@@ -0,0 +1,70 @@
+import unittest
+import ctypes
+import struct
+
+import jit
+import jit.codec
+
+class TestCodec(unittest.TestCase):
+    def setUp(self):
+        self.context = jit.Context()
+        self.values = [(i * 1000, -i, i / 4.0) for i in range(-5, 6)]
+
+    def _packed_type(self):
+        # int32 id, int16 delta, float64 value without padding.
+        type_ = jit.Type.create_struct(
+            [jit.Type.INT, jit.Type.SHORT, jit.Type.FLOAT64])
+        type_.set_offset(1, 4)
+        type_.set_offset(2, 6)
+        type_.set_size_and_alignment(14, 1)
+        type_.set_names(["id", "delta", "value"])
+        return type_
+
+    def _columns(self, n):
+        return [jit.Array(jit.Type.INT, n), jit.Array(jit.Type.SHORT, n),
+                jit.Array(jit.Type.FLOAT64, n)]
+
+    def _roundtrip(self, byteorder, prefix):
+        codec = jit.codec.compile(self._packed_type(), byteorder,
+                                  context=self.context)
+        self.assertEqual(codec.names, ("id", "delta", "value"))
+        n = len(self.values)
+        records = "".join(struct.pack(prefix + "ihd", *v)
+                          for v in self.values)
+        columns = self._columns(n)
+        self.assertEqual(codec.decode(records, columns), n)
+        self.assertEqual(zip(*[list(column) for column in columns]),
+                         self.values)
+
+        out = bytearray(len(records))
+        self.assertEqual(codec.encode(columns, out), n)
+        self.assertEqual(str(out), records)
+
+    def test_little_endian(self):
+        self._roundtrip("little", "<")
+
+    def test_big_endian(self):
+        self._roundtrip("big", ">")
+
+    def test_native_layout(self):
+        type_ = jit.Type.create_struct([jit.Type.UBYTE, jit.Type.UINT])
+        codec = jit.codec.compile(type_, context=self.context, unroll=1)
+        record = struct.pack("=BxxxI", 7, 2 ** 32 - 1)
+        columns = [jit.Array(jit.Type.UBYTE, 1), jit.Array(jit.Type.UINT, 1)]
+        codec.decode(record, columns)
+        self.assertEqual([columns[0][0], columns[1][0]], [7, 2 ** 32 - 1])
+
+    def test_errors(self):
+        codec = jit.codec.compile(self._packed_type(), context=self.context)
+        with self.assertRaises(ValueError):
+            codec.decode("\0" * 15, self._columns(1))
+        with self.assertRaises(ValueError):
+            codec.decode("\0" * 28, self._columns(1))
+        with self.assertRaises(ValueError):
+            codec.decode("\0" * 14, self._columns(1)[:2])
+        with self.assertRaises(ValueError):
+            jit.codec.compile(self._packed_type(), "middle")
+        with self.assertRaises(TypeError):
+            jit.codec.compile(jit.Type.INT)
+        with self.assertRaises(TypeError):
+            jit.codec.compile(jit.Type.create_struct([jit.Type.VOID_PTR]))
@@ -34,3 +34,31 @@ def test_free_meta(self):
         context.free_meta(type_)
         self.assertIsNone(context.get_meta(type_))
 
+
+    def test_iteration(self):
+        context = jit.Context()
+        self.assertEqual(list(context), [])
+        signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.INT, [jit.Type.INT])
+        function = jit.Function(context, signature)
+        function2 = jit.Function(context, signature)
+        self.assertEqual(list(context), [function, function2])
+
+    def test_compile_all(self):
+        context = jit.Context()
+        signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.INT, [jit.Type.INT])
+        functions = []
+        for i in range(3):
+            function = jit.Function(context, signature)
+            function.insn_return(function.value_get_param(0) + i)
+            functions.append(function)
+        functions[0].compile_()
+
+        compiled = context.compile_all()
+        self.assertEqual([function for function, _ in compiled], functions[1:])
+        for function, seconds in compiled:
+            self.assertTrue(function.is_compiled())
+            self.assertGreaterEqual(seconds, 0.0)
+        self.assertEqual(functions[2](1), 3)
+        self.assertEqual(context.compile_all(), [])
@@ -0,0 +1,17 @@
+import unittest
+
+import jit
+
+class TestReadElf(unittest.TestCase):
+    def test_missing_file(self):
+        with self.assertRaises(IOError):
+            jit.ReadElf("/nonexistent/libfoo.so")
+
+    def test_not_elf(self):
+        with self.assertRaises(ValueError):
+            jit.ReadElf(__file__)
+
+class TestWriteElf(unittest.TestCase):
+    def test_constructor(self):
+        writer = jit.WriteElf("libfoo.so")
+        self.assertTrue(writer.add_needed("libc.so.6"))
@@ -1,4 +1,7 @@
 import unittest
+import ctypes
+import gc
+import threading
 
 import jit
 
@@ -91,3 +94,214 @@ def func(x):
             return x
         self.assertEqual(func(1), 32)
 
+
+    def test_decorator_shares_identical_functions(self):
+        signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.INT, [jit.Type.INT])
+        context = jit.Context()
+
+        @jit.builds_function(context, signature)
+        def double(x):
+            return x * 2
+
+        @jit.builds_function(context, signature)
+        def twice(y):
+            return y * 2
+
+        @jit.builds_function(context, signature)
+        def triple(x):
+            return x * 3
+
+        other_context = jit.Context()
+
+        @jit.builds_function(other_context, signature)
+        def other(x):
+            return x * 3
+
+        gc.collect()
+        num_cached = len(jit._ir_cache)
+        self.assertEqual(double(3), 6)
+        self.assertEqual(twice(4), 8)
+        self.assertEqual(len(jit._ir_cache), num_cached + 1)
+        # The duplicate built for `twice' is removed from the context.
+        self.assertEqual(len(list(context)), 1)
+        self.assertEqual(context.compile_all(), [])
+        self.assertEqual(triple(3), 9)
+        self.assertEqual(len(jit._ir_cache), num_cached + 2)
+        # Identical functions are shared across contexts as well, so
+        # `other' uses the function compiled for `triple'.
+        self.assertEqual(other(5), 15)
+        self.assertEqual(len(jit._ir_cache), num_cached + 2)
+        self.assertEqual(len(list(context)), 2)
+        self.assertEqual(list(other_context), [])
+
+        del double, twice, triple, other
+        gc.collect()
+        self.assertEqual(len(jit._ir_cache), num_cached)
+
+    def test_compile_error(self):
+        self.assertTrue(issubclass(jit.CompileError, RuntimeError))
+        # Branching to a label which is never placed fails to compile.
+        jit.Insn.branch(self.function, jit.Label())
+        self.function.insn_return(self.value)
+        with self.assertRaises(jit.CompileError) as cm:
+            self.function.compile_()
+        self.assertEqual(cm.exception.result, jit.RESULT_UNDEFINED_LABEL)
+        self.assertFalse(self.function.is_compiled())
+
+    def test_loop(self):
+        total = jit.Value.create(self.function, jit.Type.NINT)
+        jit.Insn.store(self.function, total,
+                       jit.Value.create_nint_constant(
+                           self.function, jit.Type.NINT, 0))
+
+        @self.function.loop(1, self.value, unroll=4)
+        def body(i):
+            jit.Insn.store(self.function, total, total + i)
+        self.assertTrue(callable(body))
+
+        self.function.insn_return(total)
+        for n in range(12):
+            self.assertEqual(self.function(n), sum(range(1, n)))
+
+    def test_loop_with_negative_step(self):
+        total = jit.Value.create(self.function, jit.Type.NINT)
+        jit.Insn.store(self.function, total,
+                       jit.Value.create_nint_constant(
+                           self.function, jit.Type.NINT, 0))
+
+        @self.function.loop(self.value, 0, step=-3, unroll=2)
+        def body(i):
+            jit.Insn.store(self.function, total, total + i)
+
+        self.function.insn_return(total)
+        for n in range(12):
+            self.assertEqual(self.function(n), sum(range(n, 0, -3)))
+        with self.assertRaises(ValueError):
+            self.function.loop(0, 1, step=0)
+        with self.assertRaises(ValueError):
+            self.function.loop(0, 1, unroll=0)
+
+    def test_select(self):
+        self.function.insn_return(
+            self.function.select(self.value > 3, self.value * 2, 7))
+        self.assertEqual(self.function(5), 10)
+        self.assertEqual(self.function(3), 7)
+        with self.assertRaises(TypeError):
+            self.function.select(self.value, 1, 2)
+
+        with jit.Context() as context:
+            signature = jit.Type.create_signature(
+                jit.ABI_CDECL, jit.Type.FLOAT64, [jit.Type.FLOAT64])
+            function = jit.Function(context, signature)
+            x = function.value_get_param(0)
+            function.insn_return(function.select(x < 0.0, -x, x))
+        self.assertEqual(function(-2.5), 2.5)
+        self.assertEqual(function(1.25), 1.25)
+
+    def test_marshal_primitive_types(self):
+        for type_, arg in ((jit.Type.SBYTE, -3), (jit.Type.USHORT, 65535),
+                           (jit.Type.LONG, -2 ** 40),
+                           (jit.Type.ULONG, 2 ** 64 - 1),
+                           (jit.Type.FLOAT32, 0.5), (jit.Type.FLOAT64, 0.1)):
+            signature = jit.Type.create_signature(
+                jit.ABI_CDECL, type_, [type_])
+            with jit.Context() as context:
+                function = jit.Function(context, signature)
+                function.insn_return(function.value_get_param(0))
+            self.assertEqual(function(arg), arg)
+        # `function' takes a float64, which does not accept strings.
+        with self.assertRaises(TypeError):
+            function("0.1")
+        self.function.insn_return(self.value)
+        with self.assertRaises(OverflowError):
+            self.function(2 ** 31)
+
+    def test_marshal_buffers(self):
+        signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.INT,
+            [jit.Type.INT.create_pointer(), jit.Type.INT])
+        with jit.Context() as context:
+            function = jit.Function(context, signature)
+            pointer = function.value_get_param(0)
+            index = function.value_get_param(1)
+            value = jit.Insn.load_elem(function, pointer, index, jit.Type.INT)
+            jit.Insn.store_elem(function, pointer, index, value * 2)
+            function.insn_return(value)
+
+        # The buffer is passed without copying, so the store is visible.
+        data = (ctypes.c_int * 3)(4, 5, 6)
+        self.assertEqual(function(data, 1), 5)
+        self.assertEqual(list(data), [4, 10, 6])
+        self.assertEqual(function(ctypes.addressof(data), 2), 6)
+        self.assertEqual(list(data), [4, 10, 12])
+
+        with self.assertRaises(TypeError):
+            function((ctypes.c_double * 3)(), 0)
+        with self.assertRaises(TypeError):
+            function(bytearray(12), 0)
+        with self.assertRaises(TypeError):
+            function([1, 2, 3], 0)
+
+    def test_marshal_structs(self):
+        struct = jit.Type.create_struct((jit.Type.INT, jit.Type.FLOAT64))
+        struct.set_names(("count", "total"))
+        signature = jit.Type.create_signature(jit.ABI_CDECL, struct, [struct])
+        with jit.Context() as context:
+            function = jit.Function(context, signature)
+            src = jit.Insn.address_of(function, function.value_get_param(0))
+            result = jit.Value.create(function, struct)
+            dest = jit.Insn.address_of(function, result)
+            dest.set_field("count", src.field("count") + 1)
+            dest.set_field("total", src.field("total") * 2)
+            function.insn_return(result)
+
+        self.assertEqual(function((1, 1.5)), (2, 3.0))
+        self.assertEqual(function({"total": 0.25}), (1, 0.5))
+
+        class Record(ctypes.Structure):
+            _fields_ = [("count", ctypes.c_int), ("total", ctypes.c_double)]
+        out = Record()
+        self.assertIs(function.apply_([Record(4, 2.0)], out=out), out)
+        self.assertEqual((out.count, out.total), (5, 4.0))
+
+        with self.assertRaises(ValueError):
+            function((1, 2.0, 3))
+        with self.assertRaises(KeyError):
+            function({"missing": 1})
+        with self.assertRaises(ValueError):
+            function.apply_([(1, 1.0)], out=bytearray(1))
+
+    def test_apply_without_gil(self):
+        signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.NINT,
+            [jit.Type.INT.create_pointer(), jit.Type.NINT])
+        with jit.Context() as context:
+            function = jit.Function(context, signature)
+            pointer = function.value_get_param(0)
+            total = jit.Value.create(function, jit.Type.NINT)
+            jit.Insn.store(function, total,
+                           jit.Value.create_nint_constant(
+                               function, jit.Type.NINT, 0))
+
+            @function.loop(0, function.value_get_param(1))
+            def body(i):
+                jit.Insn.store(function, total, total + jit.Insn.load_elem(
+                    function, pointer, i, jit.Type.INT))
+            function.insn_return(total)
+
+        data = (ctypes.c_int * 1000)(*range(1000))
+        self.assertEqual(function.apply_([data, 10], release_gil=False), 45)
+        self.assertEqual(function.apply_([data, 1000], release_gil=True),
+                         499500)
+
+        # Calls which don't hold the GIL may overlap.
+        results = []
+        def worker():
+            results.append(function.apply_([data, 1000], release_gil=True))
+        threads = [threading.Thread(target=worker) for _ in range(4)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(results, [499500] * 4)
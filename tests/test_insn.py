@@ -1,4 +1,6 @@
 import unittest
+import ctypes
+import ctypes.util
 
 import jit
 
@@ -37,3 +39,101 @@ def test_trigonometric_methods(self):
             self.assertNotEqual(value, self.value0)
             self.assertNotEqual(value, self.value1)
 
+
+    def test_call(self):
+        context = self.function.get_context()
+        signature = self.function.get_signature()
+        callee = jit.Function(context, signature)
+        callee.insn_return(
+            callee.value_get_param(0) - callee.value_get_param(1))
+
+        # Argument counts are checked against the signature.
+        with self.assertRaises(TypeError):
+            self.function.insn_call("sub", callee, None, [self.value0])
+
+        value = self.function.insn_call(
+            "sub", callee, None, [self.value1, self.value0],
+            flags=jit.CALL_NOTHROW)
+        self.function.insn_return(value)
+        callee.compile_()
+        self.assertEqual(self.function(3, 10), 7)
+
+    def test_call_native(self):
+        libc = ctypes.CDLL(ctypes.util.find_library("c"))
+        address = ctypes.cast(libc.abs, ctypes.c_void_p).value
+        signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.SYS_INT, [jit.Type.SYS_INT])
+        value = jit.Insn.call_native(
+            self.function, "abs", address, signature,
+            [self.value0 - self.value1])
+        self.function.insn_return(value)
+        self.assertEqual(self.function(3, 10), 7)
+
+    def test_memory_methods(self):
+        signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.VOID,
+            [jit.Type.VOID_PTR, jit.Type.VOID_PTR, jit.Type.NUINT])
+        with jit.Context() as context:
+            function = jit.Function(context, signature)
+            dest, src, size = [function.value_get_param(i) for i in range(3)]
+            scratch = function.insn_alloca(size)
+            function.insn_memset(scratch, ord("x"), size)
+            function.insn_memcpy(dest, scratch, size)
+            function.insn_memmove(dest, src, 2)
+            function.insn_return(None)
+        closure = jit.Closure(function)
+        dest = ctypes.create_string_buffer(4)
+        src = ctypes.create_string_buffer("ab")
+        closure(ctypes.addressof(dest), ctypes.addressof(src), 4)
+        self.assertEqual(dest.raw, "abxx")
+
+    def test_jump_table(self):
+        labels = [jit.Label() for i in range(3)]
+        self.function.insn_jump_table(self.value0, labels)
+        self.function.insn_return(
+            jit.Value.create_nint_constant(self.function, jit.Type.INT, -1))
+        for index, label in enumerate(labels):
+            self.function.insn_label(label)
+            self.function.insn_return(self.value1 * (index + 1))
+        for index in range(3):
+            self.assertEqual(self.function(index, 5), 5 * (index + 1))
+        self.assertEqual(self.function(3, 5), -1)
+
+    def test_builtin_exceptions(self):
+        self.function.insn_return(self.value0 / self.value1)
+        self.assertEqual(self.function(6, 3), 2)
+        with self.assertRaises(ZeroDivisionError):
+            self.function(6, 0)
+
+        with jit.Context() as context:
+            function = jit.Function(context, self.function.get_signature())
+            function.insn_return(function.insn_add_ovf(
+                function.value_get_param(0), function.value_get_param(1)))
+        with self.assertRaises(OverflowError):
+            function(2 ** 31 - 1, 1)
+
+    def test_throw_and_catch(self):
+        def constant(value):
+            return jit.Value.create_nint_constant(
+                self.function, jit.Type.NINT, value)
+
+        jit.Insn.uses_catcher(self.function)
+        done = jit.Label()
+        jit.Insn.branch_if_not(self.function, self.value0, done)
+        jit.Insn.throw(self.function, constant(42))
+        jit.Insn.label(self.function, done)
+        self.function.insn_return(self.value1)
+        thrown = jit.Insn.start_catcher(self.function)
+        self.function.insn_return(
+            jit.Insn.convert(self.function, thrown, jit.Type.INT, False))
+        self.assertEqual(self.function(0, 5), 5)
+        self.assertEqual(self.function(1, 5), 42)
+
+    def test_uncaught_throw(self):
+        jit.Insn.throw(self.function, jit.Value.create_nint_constant(
+            self.function, jit.Type.NINT, 0x1234))
+        self.function.insn_return(self.value0)
+        with self.assertRaises(jit.ThrownError) as cm:
+            self.function(0, 0)
+        self.assertEqual(cm.exception.value, 0x1234)
+        self.assertIsNone(cm.exception.result)
@@ -0,0 +1,252 @@
+import unittest
+import ctypes
+import os
+import struct
+import tempfile
+import zlib
+
+import jit
+import jit.kernels
+
+# Reference implementations of the hash functions.
+
+_MASK = 2 ** 64 - 1
+
+def _rotl(x, r):
+    return ((x << r) | (x >> (64 - r))) & _MASK
+
+def _fnv1a(data, seed=0):
+    h = 0xcbf29ce484222325
+    for byte in bytearray(data):
+        h = ((h ^ byte) * 0x100000001b3) & _MASK
+    return h
+
+def _murmur(data, seed=0):
+    m = 0xc6a4a7935bd1e995
+    h = (seed ^ (len(data) * m)) & _MASK
+    blocks, tail = divmod(len(data), 8)
+    for i in range(blocks):
+        k, = struct.unpack_from("<Q", data, 8 * i)
+        k = (k * m) & _MASK
+        k ^= k >> 47
+        k = (k * m) & _MASK
+        h = ((h ^ k) * m) & _MASK
+    if tail:
+        for i, byte in enumerate(bytearray(data[8 * blocks:])):
+            h ^= byte << (8 * i)
+        h = (h * m) & _MASK
+    h ^= h >> 47
+    h = (h * m) & _MASK
+    return h ^ (h >> 47)
+
+_P1, _P2, _P3, _P4, _P5 = (0x9e3779b185ebca87, 0xc2b2ae3d27d4eb4f,
+                      0x165667b19e3779f9, 0x85ebca77c2b2ae63,
+                      0x27d4eb2f165667c5)
+
+def _xxhash(data, seed=0):
+    def round_(acc, lane):
+        return (_rotl((acc + lane * _P2) & _MASK, 31) * _P1) & _MASK
+
+    n, offset = len(data), 0
+    if n >= 32:
+        accs = [(seed + _P1 + _P2) & _MASK, (seed + _P2) & _MASK, seed,
+                (seed - _P1) & _MASK]
+        while offset + 32 <= n:
+            lanes = struct.unpack_from("<4Q", data, offset)
+            accs = [round_(a, l) for a, l in zip(accs, lanes)]
+            offset += 32
+        h = (_rotl(accs[0], 1) + _rotl(accs[1], 7) + _rotl(accs[2], 12) +
+             _rotl(accs[3], 18)) & _MASK
+        for acc in accs:
+            h = ((h ^ round_(0, acc)) * _P1 + _P4) & _MASK
+    else:
+        h = (seed + _P5) & _MASK
+    h = (h + n) & _MASK
+    while offset + 8 <= n:
+        k, = struct.unpack_from("<Q", data, offset)
+        h = (_rotl(h ^ round_(0, k), 27) * _P1 + _P4) & _MASK
+        offset += 8
+    if offset + 4 <= n:
+        k, = struct.unpack_from("<I", data, offset)
+        h = (_rotl(h ^ ((k * _P1) & _MASK), 23) * _P2 + _P3) & _MASK
+        offset += 4
+    while offset < n:
+        h = (_rotl(h ^ ((bytearray(data[offset:offset + 1])[0] * _P5) & _MASK),
+                  11) * _P1) & _MASK
+        offset += 1
+    h ^= h >> 33
+    h = (h * _P2) & _MASK
+    h ^= h >> 29
+    h = (h * _P3) & _MASK
+    return h ^ (h >> 32)
+
+class TestKernels(unittest.TestCase):
+    def setUp(self):
+        self.context = jit.Context()
+
+    def test_elementwise(self):
+        function = jit.kernels.elementwise(
+            self.context, lambda x, y: x * y + 1,
+            {"x": "float64", "y": "float64"}, "float64", unroll=4)
+        closure = jit.Closure(function)
+        for n in range(10):
+            x = (ctypes.c_double * n)(*range(n))
+            y = (ctypes.c_double * n)(*[2.5] * n)
+            out = (ctypes.c_double * n)()
+            closure(ctypes.addressof(x), ctypes.addressof(y),
+                    ctypes.addressof(out), n)
+            self.assertEqual(list(out), [i * 2.5 + 1 for i in range(n)])
+
+    def test_elementwise_converts_result(self):
+        function = jit.kernels.elementwise(
+            self.context, lambda a: a - 3, {"a": "int32"}, "int8", unroll=1)
+        closure = jit.Closure(function)
+        a = (ctypes.c_int32 * 5)(*range(5))
+        out = (ctypes.c_byte * 5)()
+        closure(ctypes.addressof(a), ctypes.addressof(out), 5)
+        self.assertEqual(list(out), [-3, -2, -1, 0, 1])
+
+    def test_elementwise_arguments(self):
+        with self.assertRaises(ValueError):
+            jit.kernels.elementwise(
+                self.context, lambda x: x, {"y": "int32"}, "int32")
+        with self.assertRaises(ValueError):
+            jit.kernels.elementwise(
+                self.context, lambda x: x, {"x": "complex"}, "int32")
+        with self.assertRaises(ValueError):
+            jit.kernels.elementwise(
+                self.context, lambda x: x, {"x": "int32"}, "int32", unroll=0)
+
+    def test_reduce(self):
+        values = [3.5, -1.0, 8.25, 0.5, 2.0, -7.5, 4.0]
+        x = (ctypes.c_double * len(values))(*values)
+        y = (ctypes.c_double * len(values))(*range(len(values)))
+        # The values are exactly representable, so the order of summation
+        # does not matter.
+        for op, reference in (("sum", sum), ("min", min), ("max", max)):
+            for accumulators in (1, 3, 4):
+                closure = jit.Closure(jit.kernels.reduce(
+                    self.context, op, "float64", accumulators=accumulators))
+                for n in range(1, len(values) + 1):
+                    self.assertEqual(closure(ctypes.addressof(x), n),
+                                     reference(values[:n]))
+
+        closure = jit.Closure(
+            jit.kernels.reduce(self.context, "dot", "float64"))
+        self.assertEqual(
+            closure(ctypes.addressof(x), ctypes.addressof(y), len(values)),
+            sum(a * b for a, b in zip(values, range(len(values)))))
+
+    def test_reduce_count_if(self):
+        values = range(-5, 6)
+        x = (ctypes.c_int32 * len(values))(*values)
+        closure = jit.Closure(jit.kernels.reduce(
+            self.context, "count_if", "int32", predicate=lambda v: v > 1))
+        self.assertEqual(closure(ctypes.addressof(x), len(values)), 4)
+        self.assertEqual(closure(ctypes.addressof(x), 0), 0)
+
+        with self.assertRaises(ValueError):
+            jit.kernels.reduce(self.context, "count_if", "int32")
+        with self.assertRaises(ValueError):
+            jit.kernels.reduce(self.context, "product", "int32")
+
+    def _write_records(self, values):
+        f = tempfile.NamedTemporaryFile(delete=False)
+        self.addCleanup(os.remove, f.name)
+        f.write(buffer((ctypes.c_int32 * len(values))(*values)))
+        f.close()
+        return f.name
+
+    def test_stream_mmap(self):
+        values = range(-1000, 5001)
+        path = self._write_records(values)
+        function = jit.kernels.reduce(self.context, "sum", "int32")
+        for chunk_records in (0, 1, 7, 4096):
+            self.assertEqual(
+                function.stream_mmap(path, jit.Type.INT, chunk_records),
+                sum(values))
+
+        function = jit.kernels.reduce(
+            self.context, "count_if", "int32", predicate=lambda v: v < 0)
+        self.assertEqual(
+            function.stream_mmap(path, jit.Type.INT, 100, prefetch=False),
+            1000)
+
+        # Functions returning nothing yield the number of records processed.
+        signature = jit.Type.create_signature(
+            jit.ABI_CDECL, None, [jit.Type.VOID_PTR, jit.Type.NINT])
+        function = jit.Function(self.context, signature)
+        function.insn_return(None)
+        function.compile_()
+        self.assertEqual(function.stream_mmap(path, jit.Type.INT, 64),
+                         len(values))
+
+        with self.assertRaises(ValueError):
+            function.stream_mmap(path, jit.Type.LONG)
+        with self.assertRaises(IOError):
+            function.stream_mmap(path + ".missing", jit.Type.INT)
+        with self.assertRaises(TypeError):
+            jit.kernels.elementwise(
+                self.context, lambda x: x, {"x": "int32"},
+                "int32").stream_mmap(path, jit.Type.INT)
+
+    def test_hash_reference(self):
+        # Known answers which validate the reference implementations.
+        self.assertEqual(_fnv1a("a"), 0xaf63dc4c8601ec8c)
+        self.assertEqual(_xxhash("a"), 0xd24ec4f1a98c6e5b)
+        self.assertEqual(
+            _xxhash("Nobody inspects the spammish repetition"),
+            0xfbcea83c8a378bf1)
+
+    def test_hash(self):
+        data = "".join(chr((i * 37 + 11) % 256) for i in range(64))
+        references = {"fnv1a": _fnv1a, "murmur": _murmur, "xxhash": _xxhash}
+        for algorithm, reference in references.items():
+            for key_size in (1, 3, 8, 12, 16, 31, 32, 40, 64):
+                function = jit.kernels.hash(self.context, key_size, algorithm,
+                                            seed=42)
+                key = data[:key_size]
+                self.assertEqual(function(key), reference(key, 42),
+                                 (algorithm, key_size))
+
+        with self.assertRaises(ValueError):
+            jit.kernels.hash(self.context, 0)
+        with self.assertRaises(ValueError):
+            jit.kernels.hash(self.context, 8, "crc")
+
+    def test_hash_batch(self):
+        keys = [struct.pack("<QQ", i, i * i) for i in range(10)]
+        out = jit.Array(jit.Type.ULONG, len(keys))
+        function = jit.kernels.hash(self.context, 16, "xxhash", batch=True)
+        function("".join(keys), out, len(keys))
+        self.assertEqual(list(out), [_xxhash(key) for key in keys])
+
+    def _checksum_data(self):
+        return "".join(chr((i * 131 + i // 7) % 256) for i in range(20000))
+
+    def test_crc32(self):
+        function = jit.kernels.crc32(self.context)
+        data = self._checksum_data()
+        for n in (0, 1, 7, 8, 9, 63, 1000, len(data)):
+            self.assertEqual(function(data, n, 0),
+                             zlib.crc32(data[:n]) & 0xffffffff, n)
+
+        # Checksums can be continued across blocks, with the GIL released.
+        crc = 0
+        for start in range(0, len(data), 4099):
+            block = data[start:start + 4099]
+            crc = function.apply_([block, len(block), crc], release_gil=True)
+        self.assertEqual(crc, zlib.crc32(data) & 0xffffffff)
+
+    def test_adler32(self):
+        function = jit.kernels.adler32(self.context)
+        data = self._checksum_data()
+        for n in (0, 1, 7, 5552, 5553, len(data)):
+            self.assertEqual(function(data, n, 1),
+                             zlib.adler32(data[:n]) & 0xffffffff, n)
+
+        array = jit.Array(jit.Type.UBYTE, len(data))
+        array[:] = bytearray(data)
+        self.assertEqual(
+            function.apply_([array, len(data), 1], release_gil=True),
+            zlib.adler32(data) & 0xffffffff)
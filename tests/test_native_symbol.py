@@ -0,0 +1,22 @@
+import unittest
+import math
+
+import jit
+
+class TestNativeSymbol(unittest.TestCase):
+    def setUp(self):
+        self.signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.FLOAT64, [jit.Type.FLOAT64])
+
+    def test_resolve(self):
+        cos = jit.NativeSymbol("m", "cos", self.signature)
+        self.assertEqual(cos.address, jit.NativeSymbol.resolve("m", "cos"))
+        with self.assertRaises(ValueError):
+            jit.NativeSymbol("m", "no_such_symbol", self.signature)
+
+    def test_call(self):
+        expm1 = jit.NativeSymbol("m", "expm1", self.signature)
+        context = jit.Context()
+        function = jit.Function(context, self.signature)
+        function.insn_return(expm1(function, function.value_get_param(0)))
+        self.assertAlmostEqual(function(1e-3), math.expm1(1e-3))
@@ -0,0 +1,110 @@
+import unittest
+
+import jit
+import jit.query
+from jit.query import col
+
+class TestQuery(unittest.TestCase):
+    def setUp(self):
+        self.context = jit.Context()
+        self.prices = [float(i % 7) * 1.5 for i in range(50)]
+        self.quantities = [i % 4 for i in range(50)]
+        n = len(self.prices)
+        self.price = jit.Array(jit.Type.FLOAT64, n)
+        self.price[:] = self.prices
+        self.qty = jit.Array(jit.Type.INT, n)
+        self.qty[:] = self.quantities
+        self.selection = jit.Array(jit.Type.UINT, n)
+
+    def _select(self, expr):
+        function = jit.query.compile_filter(
+            expr, {"price": "float64", "qty": "int32"}, context=self.context)
+        n = len(self.prices)
+        count = function(self.price, self.qty, self.selection, n)
+        return list(self.selection[:count])
+
+    def _expected(self, predicate):
+        return [i for i, row in enumerate(zip(self.prices, self.quantities))
+                if predicate(*row)]
+
+    def test_comparisons(self):
+        self.assertEqual(self._select(col("price") > 4),
+                         self._expected(lambda p, q: p > 4))
+        self.assertEqual(self._select(2 <= col("qty")),
+                         self._expected(lambda p, q: 2 <= q))
+        self.assertEqual(self._select(col("price") * 2 == col("qty") * 3),
+                         self._expected(lambda p, q: p * 2 == q * 3))
+
+    def test_connectives(self):
+        self.assertEqual(
+            self._select((col("price") >= 3.0) & ~(col("qty") == 0)),
+            self._expected(lambda p, q: p >= 3.0 and not q == 0))
+        self.assertEqual(
+            self._select((col("price") < 1) | (col("qty") == 3)),
+            self._expected(lambda p, q: p < 1 or q == 3))
+        self.assertEqual(self._select(col("qty").isin([0, 2])),
+                         self._expected(lambda p, q: q in (0, 2)))
+
+    def test_no_matches(self):
+        self.assertEqual(self._select(col("price") < 0), [])
+
+    def test_errors(self):
+        with self.assertRaises(ValueError):
+            jit.query.compile_filter(col("volume") > 0, {"price": "float64"})
+        with self.assertRaises(TypeError):
+            jit.query.compile_filter(lambda row: True, {"price": "float64"})
+        with self.assertRaises(ValueError):
+            jit.query.compile_filter(
+                col("price") > 0, [("price", "float64"), ("price", "int32")])
+
+class TestHashAggregate(unittest.TestCase):
+    def setUp(self):
+        self.context = jit.Context()
+        self.keys = [(i * 7919) % 13 - 6 for i in range(200)]
+        self.values = [float((i * 31) % 17) - 8.0 for i in range(200)]
+
+    def _columns(self):
+        keys = jit.Array(jit.Type.LONG, len(self.keys))
+        keys[:] = self.keys
+        values = jit.Array(jit.Type.FLOAT64, len(self.values))
+        values[:] = self.values
+        return keys, values
+
+    def test_aggregates(self):
+        aggregate = jit.query.compile_hash_aggregate(
+            "int64", [("sum", "float64"), "count", ("min", "float64"),
+                      ("max", "float64")], context=self.context)
+        keys, values = self._columns()
+        table = aggregate.new_table(32)
+        n = len(self.keys)
+        self.assertEqual(aggregate(keys, [values, values, values], table, n),
+                         n)
+
+        expected = {}
+        for key, value in zip(self.keys, self.values):
+            expected.setdefault(key, []).append(value)
+        groups = aggregate.groups(table)
+        self.assertEqual(sorted(groups), sorted(expected))
+        for key, group in expected.items():
+            self.assertEqual(groups[key],
+                             (sum(group), len(group), min(group), max(group)))
+
+    def test_full_table(self):
+        aggregate = jit.query.compile_hash_aggregate(
+            "int64", ["count"], context=self.context)
+        keys, _ = self._columns()
+        table = aggregate.new_table(8)
+        processed = aggregate(keys, [], table, len(self.keys))
+        self.assertEqual(len(set(self.keys[:processed])), 8)
+        self.assertNotIn(self.keys[processed], self.keys[:processed])
+        self.assertEqual(sum(count for count, in
+                             aggregate.groups(table).values()), processed)
+
+    def test_errors(self):
+        aggregate = jit.query.compile_hash_aggregate("int32", ["count"])
+        with self.assertRaises(ValueError):
+            aggregate.new_table(12)
+        with self.assertRaises(TypeError):
+            jit.query.compile_hash_aggregate("float64", ["count"])
+        with self.assertRaises(ValueError):
+            jit.query.compile_hash_aggregate("int32", [("mean", "int32")])
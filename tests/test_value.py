@@ -1,4 +1,5 @@
 import unittest
+import ctypes
 
 import jit
 
@@ -54,6 +55,34 @@ def test_marshal_constants(self):
             function.insn_return(function.value_get_param(0) * 2)
         self.assertEqual(function(110), 220)
 
+    def test_struct_fields(self):
+        struct = jit.Type.create_struct(
+            (jit.Type.SBYTE, jit.Type.INT, jit.Type.FLOAT64))
+        struct.set_names(("flag", "count", "total"))
+        signature = jit.Type.create_signature(
+            jit.ABI_CDECL, jit.Type.INT, [struct.create_pointer()])
+        with jit.Context() as context:
+            function = jit.Function(context, signature)
+            record = function.value_get_param(0)
+            count = record.field("count")
+            record.set_field("total", count * 2)
+            record.set_field("flag", 1)
+            function.insn_return(count + 1)
+            with self.assertRaises(AttributeError):
+                record.field("missing")
+            with self.assertRaises(TypeError):
+                self.param0.field("count")
+
+        class Record(ctypes.Structure):
+            _fields_ = [("flag", ctypes.c_byte), ("count", ctypes.c_int),
+                        ("total", ctypes.c_double)]
+        record = Record(0, 21, 0.0)
+        closure = jit.Closure(function)
+        pointer = ctypes.cast(ctypes.pointer(record), closure.argtypes[0])
+        self.assertEqual(closure(pointer), 22)
+        self.assertEqual(record.total, 42.0)
+        self.assertEqual(record.flag, 1)
+
     def test_invalidate_values(self):
         # TODO
         return